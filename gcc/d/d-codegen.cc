@@ -1956,6 +1956,42 @@ call_by_alias_p (FuncDeclaration *caller, FuncDeclaration *callee)
   return true;
 }
 
+// Returns TRUE if an array passed as the Nth parameter of a call to TF
+// with no 'this' or context OBJECT cannot outlive the call.  Being pure,
+// the callee cannot store it in a global; being nothrow, it cannot throw
+// it in an exception.  With no pointers in its other parameters or in its
+// result, there is nowhere else left for the array to go.
+
+static bool
+array_param_noescape_p (TypeFunction *tf, tree object, size_t n)
+{
+  if (object != NULL_TREE || tf->varargs)
+    return false;
+
+  if (tf->purity == PUREimpure || !tf->isnothrow || tf->isref)
+    return false;
+
+  if (tf->next->hasPointers())
+    return false;
+
+  size_t nparams = Parameter::dim (tf->parameters);
+  for (size_t i = 0; i < nparams; i++)
+    {
+      Parameter *parg = Parameter::getNth (tf->parameters, i);
+
+      if (i == n)
+	{
+	  if (parg->storageClass & (STCout | STCref | STClazy))
+	    return false;
+	}
+      else if ((parg->storageClass & (STCout | STCref))
+	       || parg->type->hasPointers())
+	return false;
+    }
+
+  return true;
+}
+
 // Entry point for call routines.  Builds a function call to FD.
 // OBJECT is the 'this' reference passed and ARGS are the arguments to FD.
 
@@ -2056,6 +2092,19 @@ d_build_call (TypeFunction *tf, tree callable, tree object, Expressions *argumen
 	    {
 	      // Actual arguments for declared formal arguments
 	      Parameter *parg = Parameter::getNth (tf->parameters, i - dvarargs);
+
+	      // An array literal that provably does not outlive the call can
+	      // be built on the stack.  A scope parameter is not enough, as
+	      // the front-end does not check it.  Work on a copy, as the
+	      // literal may be shared with other expressions.
+	      if (arg->op == TOKarrayliteral
+		  && array_param_noescape_p (tf, object, i - dvarargs))
+		{
+		  ArrayLiteralExp *ale = (ArrayLiteralExp *) arg->copy();
+		  ale->onstack = 1;
+		  arg = ale;
+		}
+
 	      targ = convert_for_argument (arg->toElem (irs), arg, parg);
 	    }
 	  else
@@ -2119,9 +2168,12 @@ d_assert_call (Loc loc, LibCall libcall, tree msg)
 
 static const char *libcall_ids[LIBCALL_count] = {
     "_D9invariant12_d_invariantFC6ObjectZv",
-    "_aaDelX", "_aaEqual",
-    "_aaGetRvalueX", "_aaGetX",
-    "_aaInX",
+    "_aaDelX", "_aaDelXi", "_aaDelXl", "_aaDelXp", "_aaDelXs",
+    "_aaEqual",
+    "_aaGetRvalueX", "_aaGetRvalueXi", "_aaGetRvalueXl",
+    "_aaGetRvalueXp", "_aaGetRvalueXs",
+    "_aaGetX", "_aaGetXi", "_aaGetXl", "_aaGetXp", "_aaGetXs",
+    "_aaInX", "_aaInXi", "_aaInXl", "_aaInXp", "_aaInXs",
     "_adCmp2", "_adEq2",
     "_d_allocmemory", "_d_array_bounds",
     "_d_arrayappendT", "_d_arrayappendcTX",
@@ -2148,6 +2200,68 @@ static const char *libcall_ids[LIBCALL_count] = {
 
 static FuncDeclaration *libcall_decls[LIBCALL_count];
 
+// Return which of the specialised AA library calls handles keys of type TKEY.
+// The runtime hashes these keys inline, so this must only return a kind
+// whose hash matches the getHash of the TypeInfo generated for TKEY.
+
+AAKeyKind
+aa_key_kind (Type *tkey)
+{
+  Type *tb = tkey->toBasetype();
+
+  switch (tb->ty)
+    {
+    case Tint32:
+    case Tuns32:
+    case Tdchar:
+      return AAKEY_INT32;
+
+    case Tint64:
+    case Tuns64:
+      return AAKEY_INT64;
+
+    case Tpointer:
+      return AAKEY_POINTER;
+
+    case Tarray:
+      // Only strings that get the builtin TypeInfo_Aa, _Axa or _Aya.
+      if (tb->nextOf()->ty == Tchar
+	  && (tb->nextOf()->mod & ~(MODconst | MODimmutable)) == 0)
+	return AAKEY_STRING;
+      break;
+
+    default:
+      break;
+    }
+
+  return AAKEY_GENERIC;
+}
+
+// Return the type that keys of KIND are passed as to the specialised
+// AA library calls.
+
+Type *
+aa_key_type (AAKeyKind kind)
+{
+  switch (kind)
+    {
+    case AAKEY_INT32:
+      return Type::tuns32;
+
+    case AAKEY_INT64:
+      return Type::tuns64;
+
+    case AAKEY_POINTER:
+      return Type::tvoidptr;
+
+    case AAKEY_STRING:
+      return Type::tchar->constOf()->arrayOf();
+
+    default:
+      gcc_unreachable();
+    }
+}
+
 // Library functions are generated as needed.
 // This could probably be changed in the future to be
 // more like GCC builtin trees.
@@ -2310,6 +2424,48 @@ get_libcall (LibCall libcall)
 	  treturn = Type::tbool;
 	  break;
 
+	case LIBCALL_AAINXI:
+	case LIBCALL_AAINXL:
+	case LIBCALL_AAINXP:
+	case LIBCALL_AAINXS:
+	  targs.push (aatype);
+	  targs.push (Type::dtypeinfo->type->constOf());
+	  targs.push (aa_key_type ((AAKeyKind) (libcall - LIBCALL_AAINX)));
+	  treturn = Type::tvoidptr;
+	  break;
+
+	case LIBCALL_AAGETXI:
+	case LIBCALL_AAGETXL:
+	case LIBCALL_AAGETXP:
+	case LIBCALL_AAGETXS:
+	  targs.push (aatype->pointerTo());
+	  targs.push (Type::dtypeinfo->type->constOf());
+	  targs.push (Type::tsize_t);
+	  targs.push (aa_key_type ((AAKeyKind) (libcall - LIBCALL_AAGETX)));
+	  treturn = Type::tvoidptr;
+	  break;
+
+	case LIBCALL_AAGETRVALUEXI:
+	case LIBCALL_AAGETRVALUEXL:
+	case LIBCALL_AAGETRVALUEXP:
+	case LIBCALL_AAGETRVALUEXS:
+	  targs.push (aatype);
+	  targs.push (Type::dtypeinfo->type->constOf());
+	  targs.push (Type::tsize_t);
+	  targs.push (aa_key_type ((AAKeyKind) (libcall - LIBCALL_AAGETRVALUEX)));
+	  treturn = Type::tvoidptr;
+	  break;
+
+	case LIBCALL_AADELXI:
+	case LIBCALL_AADELXL:
+	case LIBCALL_AADELXP:
+	case LIBCALL_AADELXS:
+	  targs.push (aatype);
+	  targs.push (Type::dtypeinfo->type->constOf());
+	  targs.push (aa_key_type ((AAKeyKind) (libcall - LIBCALL_AADELX)));
+	  treturn = Type::tbool;
+	  break;
+
 	case LIBCALL_ARRAYCAST:
 	  targs.push (Type::tsize_t);
 	  targs.push (Type::tsize_t);
@@ -2821,6 +2977,27 @@ build_typeinfo (Type *t)
   return tinfo;
 }
 
+// Return the thread-local variable _d_arrayappend_cache from rt/lifetime.d,
+// declared here as a void*[3] of the start, limit and used fields.
+
+tree
+get_append_cache (void)
+{
+  if (d_append_cache_node == NULL_TREE)
+    {
+      tree decl = build_decl (BUILTINS_LOCATION, VAR_DECL,
+			      get_identifier ("_d_arrayappend_cache"),
+			      d_array_type (Type::tvoidptr, 3));
+      DECL_EXTERNAL (decl) = 1;
+      TREE_PUBLIC (decl) = 1;
+      DECL_ARTIFICIAL (decl) = 1;
+      DECL_TLS_MODEL (decl) = decl_default_tls_model (decl);
+      d_append_cache_node = decl;
+    }
+
+  return d_append_cache_node;
+}
+
 // Checks if DECL is an intrinsic or runtime library function that
 // requires special processing.  Marks the generated trees for DECL
 // as BUILT_IN_FRONTEND so can be identified later.
@@ -46,9 +46,17 @@ enum LibCall
   LIBCALL_NONE = -1,
   LIBCALL_INVARIANT,
 
-  LIBCALL_AADELX, LIBCALL_AAEQUAL,
-  LIBCALL_AAGETRVALUEX, LIBCALL_AAGETX,
-  LIBCALL_AAINX,
+  // The specialised key versions of each AA call must directly follow
+  // the generic one, in the order of AAKeyKind.
+  LIBCALL_AADELX, LIBCALL_AADELXI, LIBCALL_AADELXL,
+  LIBCALL_AADELXP, LIBCALL_AADELXS,
+  LIBCALL_AAEQUAL,
+  LIBCALL_AAGETRVALUEX, LIBCALL_AAGETRVALUEXI, LIBCALL_AAGETRVALUEXL,
+  LIBCALL_AAGETRVALUEXP, LIBCALL_AAGETRVALUEXS,
+  LIBCALL_AAGETX, LIBCALL_AAGETXI, LIBCALL_AAGETXL,
+  LIBCALL_AAGETXP, LIBCALL_AAGETXS,
+  LIBCALL_AAINX, LIBCALL_AAINXI, LIBCALL_AAINXL,
+  LIBCALL_AAINXP, LIBCALL_AAINXS,
 
   LIBCALL_ADCMP2, LIBCALL_ADEQ2,
 
@@ -96,6 +104,16 @@ enum LibCall
   LIBCALL_count
 };
 
+// Key types that have specialised AA library calls in rt/aaA.d.
+enum AAKeyKind
+{
+  AAKEY_GENERIC,
+  AAKEY_INT32,
+  AAKEY_INT64,
+  AAKEY_POINTER,
+  AAKEY_STRING,
+};
+
 
 struct FuncFrameInfo
 {
@@ -246,11 +264,14 @@ extern tree get_object_method (tree thisexp, Expression *objexp, FuncDeclaration
 // Built-in and Library functions.
 extern FuncDeclaration *get_libcall (LibCall libcall);
 extern tree build_libcall (LibCall libcall, unsigned n_args, tree *args, tree force_type = NULL_TREE);
+extern AAKeyKind aa_key_kind (Type *tkey);
+extern Type *aa_key_type (AAKeyKind kind);
 extern tree maybe_expand_builtin (tree call_exp);
 
 extern void maybe_set_builtin_frontend (FuncDeclaration *decl);
 
 extern tree build_typeinfo (Type *t);
+extern tree get_append_cache (void);
 
 // Type management for D frontend types.
 // Returns TRUE if T1 and T2 are mutably the same type.
@@ -192,8 +192,6 @@ VarDeclaration::toSymbol (void)
 	{
 	  char *p = loc.toChars();
 	  fprintf (global.stdmsg, "%s: %s is thread local\n", p ? p : "", toChars());
-	  if (p)
-	    free (p);
 	}
     }
 
@@ -711,6 +709,8 @@ AggregateDeclaration::toInitializer (void)
 
   if (!sinit->Stree && current_module_decl)
     {
+      // May be called from CTFE through defaultInitLiteral.
+      mem_pinregion();
       tree stype;
       if (isStructDeclaration())
 	stype = type->toCtype();
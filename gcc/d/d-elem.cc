@@ -107,6 +107,101 @@ IdentityExp::toElem (IRState *irs)
     }
 }
 
+// Return the opEquals, or if CMP the opCmp, that the TypeInfo of the struct
+// type T would call, or NULL if the compiler cannot call it directly.
+
+static FuncDeclaration *
+struct_compare_function (Type *t, bool cmp)
+{
+  if (t->ty != Tstruct)
+    return NULL;
+
+  StructDeclaration *sd = ((TypeStruct *) t)->sym;
+  FuncDeclaration *fd = cmp ? sd->xcmp : sd->xeq;
+
+  if (fd == NULL || fd == StructDeclaration::xerreq
+      || fd == StructDeclaration::xerrcmp
+      || fd->semanticRun < PASSsemantic3done)
+    return NULL;
+
+  return fd;
+}
+
+// Evaluate the array operand EXP once, appending the code to do so to INIT,
+// and set PTR and LEN to the data pointer and length of the array.
+
+static void
+build_array_operand (Expression *exp, tree *init, tree *ptr, tree *len)
+{
+  Type *tb = exp->type->toBasetype();
+  tree t = exp->toElem (current_irstate);
+  tree var;
+
+  if (tb->ty == Tarray)
+    {
+      var = build_local_temp (TREE_TYPE (t));
+      *init = maybe_vcompound_expr (*init, build_vinit (var, t));
+      *ptr = d_array_ptr (var);
+      *len = d_array_length (var);
+    }
+  else
+    {
+      gcc_assert (tb->ty == Tsarray);
+      var = build_local_temp (tb->nextOf()->pointerTo()->toCtype());
+      *init = maybe_vcompound_expr (*init, build_vinit (var, build_nop (TREE_TYPE (var),
+									    build_address (t))));
+      *ptr = var;
+      *len = size_int (((TypeSArray *) tb)->dim->toInteger());
+    }
+}
+
+// Build a loop over the first LEN elements of the arrays PTR1 and PTR2 of
+// TELEM, storing the result of comparing each pair in RESULT.  If CMP, the
+// comparison is three-way and the loop stops at the first nonzero result,
+// otherwise the loop stops at the first pair that are not equal.
+
+static tree
+build_array_compare_loop (Type *telem, tree ptr1, tree ptr2, tree len,
+			  tree result, bool cmp)
+{
+  tree index = build_local_temp (size_type_node);
+  tree elem1 = build_deref (build_array_index (ptr1, index));
+  tree elem2 = build_deref (build_array_index (ptr2, index));
+  FuncDeclaration *fd = struct_compare_function (telem, cmp);
+  tree tcmp, texit;
+
+  if (fd != NULL)
+    {
+      // Call the struct opEquals or opCmp, 'this' is passed first.
+      tcmp = d_build_call_nary (fd->toSymbol()->Stree, 2,
+				build_address (elem1), build_address (elem2));
+    }
+  else if (cmp)
+    {
+      // For scalars, result = (e1 > e2) - (e1 < e2);
+      tcmp = build2 (MINUS_EXPR, TREE_TYPE (result),
+		     d_convert (TREE_TYPE (result), build_boolop (GT_EXPR, elem1, elem2)),
+		     d_convert (TREE_TYPE (result), build_boolop (LT_EXPR, elem1, elem2)));
+    }
+  else
+    tcmp = build_boolop (EQ_EXPR, elem1, elem2);
+
+  if (cmp)
+    texit = build_boolop (NE_EXPR, result, integer_zero_node);
+  else
+    texit = build1 (TRUTH_NOT_EXPR, boolean_type_node, result);
+
+  tree body = build1 (EXIT_EXPR, void_type_node,
+		      build_boolop (EQ_EXPR, index, len));
+  body = vcompound_expr (body, vmodify_expr (result, d_convert (TREE_TYPE (result), tcmp)));
+  body = vcompound_expr (body, build1 (EXIT_EXPR, void_type_node, texit));
+  body = vcompound_expr (body, vmodify_expr (index, build2 (PLUS_EXPR, size_type_node,
+							     index, size_one_node)));
+
+  return vcompound_expr (vmodify_expr (index, size_zero_node),
+			 build1 (LOOP_EXPR, void_type_node, body));
+}
+
 elem *
 EqualExp::toElem (IRState *irs)
 {
@@ -129,12 +224,15 @@ EqualExp::toElem (IRState *irs)
 	   && (tb2->ty == Tsarray || tb2->ty == Tarray))
     {
       Type *t1elem = tb1->nextOf()->toBasetype();
-      Type *t2elem = tb1->nextOf()->toBasetype();
+      Type *t2elem = tb2->nextOf()->toBasetype();
 
-      if ((t1elem->isintegral() || t1elem->ty == Tvoid) && t1elem->ty == t2elem->ty)
+      if ((t1elem->isintegral() || t1elem->ty == Tvoid || t1elem->ty == Tpointer
+	   || (t1elem->ty == Tstruct && !((TypeStruct *) t1elem)->sym->xeq))
+	  && t1elem->ty == t2elem->ty)
 	{
 	  // Optimise comparisons of arrays of basic types.
-	  // For arrays of integers/characters, and void[], replace _adEq2 call with:
+	  // For arrays of integers/characters, pointers, structs that compare
+	  // bitwise, and void[], replace _adEq2 call with:
 	  //     e1 == e2  =>  e1.length == e2.length && memcmp (e1.ptr, e2.ptr, size) == 0;
 	  //     e1 != e2  =>  e1.length != e2.length || memcmp (e1.ptr, e2.ptr, size) != 0;
 	  // 'size' is e1.length * sizeof(e1[0]) for dynamic arrays, or sizeof(e1) for static arrays.
@@ -200,6 +298,30 @@ EqualExp::toElem (IRState *irs)
 
 	  return result;
 	}
+      else if (t1elem->ty == t2elem->ty && struct_compare_function (t1elem, false))
+	{
+	  // For arrays of structs with opEquals, compare each element inline
+	  // rather than through the TypeInfo.  Arrays of floats still go to
+	  // _adEq2, as their TypeInfo takes two NaNs to be equal:
+	  //     e1 == e2  =>  e1.length == e2.length && for (i...) if (!(e1[i] == e2[i])) break;
+	  tree init = NULL_TREE;
+	  tree t1ptr, t1len, t2ptr, t2len;
+
+	  build_array_operand (e1, &init, &t1ptr, &t1len);
+	  build_array_operand (e2, &init, &t2ptr, &t2len);
+
+	  tree result = build_local_temp (boolean_type_node);
+	  tree loop = build_array_compare_loop (t1elem, t1ptr, t2ptr, t1len, result, false);
+
+	  init = vcompound_expr (init, build_vinit (result, build_boolop (EQ_EXPR, t1len, t2len)));
+	  init = vcompound_expr (init, build3 (COND_EXPR, void_type_node, result,
+					       loop, d_void_zero_node));
+
+	  if (op == TOKnotequal)
+	    result = build1 (TRUTH_NOT_EXPR, boolean_type_node, result);
+
+	  return d_convert (type->toCtype(), compound_expr (init, result));
+	}
       else
 	{
 	  // _adEq2 compares each element.
@@ -250,10 +372,21 @@ InExp::toElem (IRState *irs)
   gcc_assert (tb2->ty == Taarray);
 
   Type *tkey = ((TypeAArray *) tb2)->index->toBasetype();
+  AAKeyKind kind = aa_key_kind (tkey);
   tree args[3];
 
   args[0] = e2->toElem (irs);
   args[1] = build_typeinfo (tkey);
+
+  // Keys with a specialised library call are passed by value.
+  if (kind != AAKEY_GENERIC)
+    {
+      args[2] = convert_expr (convert_expr (e1->toElem (irs), e1->type, tkey),
+			      tkey, aa_key_type (kind));
+      return convert (type->toCtype(),
+		      build_libcall ((LibCall) (LIBCALL_AAINX + kind), 3, args));
+    }
+
   args[2] = aoe.set (convert_expr (e1->toElem (irs), e1->type, tkey));
 
   return convert (type->toCtype(),
@@ -333,12 +466,71 @@ CmpExp::toElem (IRState *irs)
       && (tb2->ty == Tsarray || tb2->ty == Tarray))
     {
       Type *telem = tb1->nextOf()->toBasetype();
-      tree args[3];
+      Type *t2elem = tb2->nextOf()->toBasetype();
 
-      args[0] = d_array_convert (e1);
-      args[1] = d_array_convert (e2);
-      args[2] = build_typeinfo (telem->arrayOf());
-      result = build_libcall (LIBCALL_ADCMP2, 3, args);
+      // Arrays of unsigned bytes, and of structs without opCmp, order the
+      // same as their contents do under memcmp.
+      bool use_memcmp = (telem->ty == Tvoid || telem->ty == Tbool
+			 || telem->ty == Tuns8 || telem->ty == Tchar
+			 || (telem->ty == Tstruct && !((TypeStruct *) telem)->sym->xcmp));
+
+      if (telem->ty == t2elem->ty && telem->ty != Tvector
+	  && (use_memcmp || telem->isintegral() || telem->ty == Tpointer
+	      || struct_compare_function (telem, true)))
+	{
+	  // Compare the arrays lexicographically inline, rather than calling
+	  // _adCmp2 to compare each element through the TypeInfo:
+	  //     len = min (e1.length, e2.length);
+	  //     result = memcmp (e1.ptr, e2.ptr, len * sizeof(e1[0]));
+	  //  or for (i...) if ((result = cmp (e1[i], e2[i])) != 0) break;
+	  //     if (result == 0) result = (e1.length > e2.length) - (e1.length < e2.length);
+	  tree init = NULL_TREE;
+	  tree t1ptr, t1len, t2ptr, t2len;
+
+	  build_array_operand (e1, &init, &t1ptr, &t1len);
+	  build_array_operand (e2, &init, &t2ptr, &t2len);
+
+	  tree len = build_local_temp (size_type_node);
+	  result = build_local_temp (Type::tint32->toCtype());
+	  init = vcompound_expr (init, build_vinit (len, build2 (MIN_EXPR, size_type_node,
+								  t1len, t2len)));
+	  if (use_memcmp)
+	    {
+	      tree tmemcmp = d_build_call_nary (builtin_decl_explicit (BUILT_IN_MEMCMP), 3,
+						t1ptr, t2ptr,
+						build2 (MULT_EXPR, size_type_node, len,
+							size_int (telem->size())));
+	      // Don't let memcmp see the pointers of empty arrays, they may be null.
+	      tmemcmp = build3 (COND_EXPR, TREE_TYPE (result),
+				build_boolop (NE_EXPR, len, size_zero_node),
+				d_convert (TREE_TYPE (result), tmemcmp), integer_zero_node);
+	      init = vcompound_expr (init, build_vinit (result, tmemcmp));
+	    }
+	  else
+	    {
+	      init = vcompound_expr (init, build_vinit (result, integer_zero_node));
+	      init = vcompound_expr (init, build_array_compare_loop (telem, t1ptr, t2ptr,
+								       len, result, true));
+	    }
+
+	  // Arrays that are equal up to the shorter length are ordered by length.
+	  tree tlencmp = build2 (MINUS_EXPR, TREE_TYPE (result),
+				 d_convert (TREE_TYPE (result), build_boolop (GT_EXPR, t1len, t2len)),
+				 d_convert (TREE_TYPE (result), build_boolop (LT_EXPR, t1len, t2len)));
+	  init = vcompound_expr (init, build3 (COND_EXPR, void_type_node,
+					       build_boolop (EQ_EXPR, result, integer_zero_node),
+					       vmodify_expr (result, tlencmp), d_void_zero_node));
+	  result = compound_expr (init, result);
+	}
+      else
+	{
+	  tree args[3];
+
+	  args[0] = d_array_convert (e1);
+	  args[1] = d_array_convert (e2);
+	  args[2] = build_typeinfo (telem->arrayOf());
+	  result = build_libcall (LIBCALL_ADCMP2, 3, args);
+	}
 
       // %% For float element types, warn that NaN is not taken into account?
 
@@ -837,6 +1029,46 @@ needsPostblit (Type *t)
   return NULL;
 }
 
+// Build the inline fast path for appending one element of type ETYPE to
+// the array pointed to by PARRAY.  The runtime records the large block that
+// it last appended to on this thread in _d_arrayappend_cache.  If the array
+// still ends at the used end of that block, and there is room for one more
+// element, grow the array and the length stored in the block in place.
+// Otherwise make CALL to _d_arrayappendcTX.
+
+static tree
+build_append_fast_path (tree parray, Type *etype, tree call)
+{
+  tree cache = get_append_cache();
+  tree ptrtype = Type::tvoidptr->toCtype();
+  tree esize = size_int (etype->size());
+  tree array = build_deref (parray);
+
+  tree start = build4 (ARRAY_REF, ptrtype, cache, size_int (0), NULL_TREE, NULL_TREE);
+  tree limit = build4 (ARRAY_REF, ptrtype, cache, size_int (1), NULL_TREE, NULL_TREE);
+  tree used = build4 (ARRAY_REF, ptrtype, cache, size_int (2), NULL_TREE, NULL_TREE);
+  used = build_deref (build_nop (build_pointer_type (size_type_node), used));
+
+  // if (array.ptr + array.length * esize == start + *used
+  //     && array.ptr + (array.length + 1) * esize <= limit)
+  tree length = d_array_length (array);
+  tree array_end = build_offset (build_nop (ptrtype, d_array_ptr (array)),
+				 fold_build2 (MULT_EXPR, size_type_node, length, esize));
+  array_end = make_temp (array_end);
+  tree cond = build_boolop (TRUTH_ANDIF_EXPR,
+			    build_boolop (EQ_EXPR, array_end, build_offset (start, used)),
+			    build_boolop (LE_EXPR, build_offset (array_end, esize), limit));
+
+  //   *used += esize, array.length += 1;
+  tree grow = vmodify_expr (used, build2 (PLUS_EXPR, size_type_node, used, esize));
+  grow = vcompound_expr (grow, vmodify_expr (length, build2 (PLUS_EXPR, TREE_TYPE (length),
+							     length, size_one_node)));
+
+  // else _d_arrayappendcTX (ti, parray, 1);
+  return build3 (COND_EXPR, void_type_node, cond, grow,
+		 vcompound_expr (call, d_void_zero_node));
+}
+
 elem *
 CatAssignExp::toElem (IRState *irs)
 {
@@ -879,20 +1111,25 @@ CatAssignExp::toElem (IRState *irs)
 	{
 	  // Append an element
 	  tree args[3];
+	  tree parray = make_temp (build_address (e1->toElem (irs)));
 
 	  args[0] = build_typeinfo (type);
-	  args[1] = build_address (e1->toElem (irs));
+	  args[1] = parray;
 	  args[2] = size_one_node;
 
-	  result = build_libcall (LIBCALL_ARRAYAPPENDCTX, 3, args, type->toCtype());
-	  result = make_temp (result);
+	  tree append = build_libcall (LIBCALL_ARRAYAPPENDCTX, 3, args, type->toCtype());
+
+	  // The runtime can't tell shared appends apart without the TypeInfo.
+	  if (optimize && !e1->type->isShared() && etype->size() != 0)
+	    append = build_append_fast_path (parray, etype, append);
 
 	  // Assign e2 to last element
-	  tree off_exp = d_array_length (result);
+	  tree array = build_deref (parray);
+	  tree off_exp = d_array_length (array);
 	  off_exp = build2 (MINUS_EXPR, TREE_TYPE (off_exp), off_exp, size_one_node);
 	  off_exp = maybe_make_temp (off_exp);
 
-	  tree ptr_exp = d_array_ptr (result);
+	  tree ptr_exp = d_array_ptr (array);
 	  ptr_exp = void_okay_p (ptr_exp);
 	  ptr_exp = build_array_index (ptr_exp, off_exp);
 
@@ -900,6 +1137,7 @@ CatAssignExp::toElem (IRState *irs)
 	  tree e2e = e2->toElem (irs);
 	  e2e = maybe_make_temp (e2e);
 	  result = modify_expr (etype->toCtype(), build_deref (ptr_exp), e2e);
+	  result = compound_expr (append, result);
 	  result = compound_expr (e2e, result);
 	}
     }
@@ -1129,6 +1367,7 @@ IndexExp::toElem (IRState *irs)
   if (tb1->ty == Taarray)
     {
       Type *tkey = ((TypeAArray *) tb1)->index->toBasetype();
+      AAKeyKind kind = aa_key_kind (tkey);
       AddrOfExpr aoe;
       tree args[4];
       LibCall libcall;
@@ -1147,9 +1386,21 @@ IndexExp::toElem (IRState *irs)
 
       args[1] = build_typeinfo (tkey);
       args[2] = build_integer_cst (tb1->nextOf()->size(), Type::tsize_t->toCtype());
-      args[3] = aoe.set (convert_expr (e2->toElem (irs), e2->type, tkey));
 
-      index = aoe.finish (build_libcall (libcall, 4, args, type->pointerTo()->toCtype()));
+      if (kind != AAKEY_GENERIC)
+	{
+	  // Keys with a specialised library call are passed by value.
+	  args[3] = convert_expr (convert_expr (e2->toElem (irs), e2->type, tkey),
+				  tkey, aa_key_type (kind));
+	  index = build_libcall ((LibCall) (libcall + kind), 4, args,
+				 type->pointerTo()->toCtype());
+	}
+      else
+	{
+	  args[3] = aoe.set (convert_expr (e2->toElem (irs), e2->type, tkey));
+	  index = aoe.finish (build_libcall (libcall, 4, args,
+					     type->pointerTo()->toCtype()));
+	}
 
       if (array_bounds_check() && !skipboundscheck)
 	{
@@ -1458,11 +1709,21 @@ RemoveExp::toElem (IRState *irs)
     {
       Type *a_type = array->type->toBasetype();
       Type *tkey = ((TypeAArray *) a_type)->index->toBasetype();
+      AAKeyKind kind = aa_key_kind (tkey);
       AddrOfExpr aoe;
       tree args[3];
 
       args[0] = array->toElem (irs);
       args[1] = build_typeinfo (tkey);
+
+      // Keys with a specialised library call are passed by value.
+      if (kind != AAKEY_GENERIC)
+	{
+	  args[2] = convert_expr (convert_expr (index->toElem (irs), index->type, tkey),
+				  tkey, aa_key_type (kind));
+	  return build_libcall ((LibCall) (LIBCALL_AADELX + kind), 3, args);
+	}
+
       args[2] = aoe.set (convert_expr (index->toElem (irs), index->type, tkey));
 
       return aoe.finish (build_libcall (LIBCALL_AADELX, 3, args));
@@ -2419,6 +2680,17 @@ ArrayLiteralExp::toElem (IRState *irs)
   if (tb->ty == Tarray && constant_p)
     return d_array_value (type->toCtype(), size_int (elements->dim), build_address (ctor));
 
+  // Nor arrays that the front-end or call site has shown do not escape.
+  if (tb->ty == Tarray && onstack && current_function_decl != NULL_TREE)
+    {
+      tree var = build_local_temp (tsa);
+      result = compound_expr (vmodify_expr (var, ctor), build_address (var));
+      return d_array_value (type->toCtype(), size_int (elements->dim), result);
+    }
+
+  warning_at (get_linemap (loc), OPT_Wheap_array_literal,
+	      "array literal %s is allocated on the heap", toChars());
+
   args[0] = build_typeinfo (etype->arrayOf());
   args[1] = build_integer_cst (elements->dim, size_type_node);
 
@@ -2466,6 +2738,20 @@ AssocArrayLiteralExp::toElem (IRState *irs)
   gcc_assert (keys != NULL);
   gcc_assert (values != NULL);
 
+  // Immutable literals of constants are laid out once in static data,
+  // instead of being built by the runtime on every evaluation.
+  if (type->isImmutable())
+    {
+      tree impl = build_static_aa_impl (this, aa_type);
+      if (impl != NULL_TREE)
+	{
+	  tree aat_type = aa_type->toCtype();
+	  vec<constructor_elt, va_gc> *ce = NULL;
+	  CONSTRUCTOR_APPEND_ELT (ce, TYPE_FIELDS (aat_type), impl);
+	  return build_nop (type->toCtype(), build_constructor (aat_type, ce));
+	}
+    }
+
   tree keys_var = create_temporary_var (d_array_type (index, keys->dim));
   tree vals_var = create_temporary_var (d_array_type (next, keys->dim));
   tree keys_ptr = build_nop (index->pointerTo()->toCtype(),
@@ -17,6 +17,11 @@
 
 #include "d-system.h"
 #include "d-objfile.h"
+#include "d-pthread.h"
+
+#ifdef HAVE_D_PTHREAD
+#include <pthread.h>
+#endif
 
 #include "mars.h"
 #include "module.h"
@@ -143,6 +148,21 @@ Loc::equals (const Loc& loc)
 }
 
 
+// Diagnostics raised while parsing a module ahead on a worker thread are
+// not printed from there.  The module is marked instead, so that it gets
+// parsed again on the main thread, which reports them in order.
+
+static bool
+parsing_ahead_p (void)
+{
+  Module *m = Module::parsingAhead;
+  if (!m)
+    return false;
+
+  m->aheadFailed = true;
+  return true;
+}
+
 // Print a hard error message.
 
 void
@@ -172,6 +192,9 @@ void
 verror (Loc loc, const char *format, va_list ap,
 	const char *p1, const char *p2, const char *)
 {
+  if (parsing_ahead_p ())
+    return;
+
   if (!global.gag)
     {
       location_t location = get_linemap (loc);
@@ -212,6 +235,9 @@ errorSupplemental (Loc loc, const char *format, ...)
 void
 verrorSupplemental (Loc loc, const char *format, va_list ap)
 {
+  if (parsing_ahead_p ())
+    return;
+
   if (!global.gag)
     {
       location_t location = get_linemap (loc);
@@ -236,6 +262,9 @@ warning (Loc loc, const char *format, ...)
 void
 vwarning (Loc loc, const char *format, va_list ap)
 {
+  if (global.params.warnings && parsing_ahead_p ())
+    return;
+
   if (global.params.warnings && !global.gag)
     {
       location_t location = get_linemap (loc);
@@ -265,6 +294,9 @@ void
 vdeprecation (Loc loc, const char *format, va_list ap,
 	      const char *p1, const char *p2)
 {
+  if (global.params.useDeprecated != 1 && parsing_ahead_p ())
+    return;
+
   if (global.params.useDeprecated == 0)
     verror (loc, format, ap, p1, p2);
   else if (global.params.useDeprecated == 2 && !global.gag)
@@ -337,6 +369,28 @@ writeFile (Loc loc, File *f)
     }
 }
 
+// Lexer::stringtable is shared by the threads parsing modules ahead.
+
+#ifdef HAVE_D_PTHREAD
+static pthread_mutex_t identifiers_lock = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+void
+lockIdentifiers (void)
+{
+#ifdef HAVE_D_PTHREAD
+  pthread_mutex_lock (&identifiers_lock);
+#endif
+}
+
+void
+unlockIdentifiers (void)
+{
+#ifdef HAVE_D_PTHREAD
+  pthread_mutex_unlock (&identifiers_lock);
+#endif
+}
+
 void
 ensurePathToNameExists (Loc loc, const char *name)
 {
@@ -27,6 +27,11 @@
 #include "d-lang.h"
 #include "d-codegen.h"
 #include "d-confdefs.h"
+#include "d-pthread.h"
+
+#ifdef HAVE_D_PTHREAD
+#include <pthread.h>
+#endif
 
 #include "mars.h"
 #include "mtype.h"
@@ -131,6 +136,9 @@ const attribute_spec d_attribute_table[] =
 
 static const char *fonly_arg;
 
+/* Number of threads to parse modules ahead on, from -fparse-threads=.  */
+static unsigned parse_threads = 0;
+
 /* List of modules being compiled.  */
 Modules output_modules;
 
@@ -430,6 +438,10 @@ d_handle_option (size_t scode, const char *arg, int value,
       global.params.verbose = value;
       break;
 
+    case OPT_fd_vclosure:
+      global.params.vclosure = value;
+      break;
+
     case OPT_fd_vtls:
       global.params.vtls = value;
       break;
@@ -493,6 +505,10 @@ d_handle_option (size_t scode, const char *arg, int value,
 	error ("bad argument for -fmake-deps");
       break;
 
+    case OPT_fmangle_backrefs:
+      global.params.mangleBackrefs = value;
+      break;
+
     case OPT_fonly_:
       fonly_arg = xstrdup (arg);
       break;
@@ -501,6 +517,10 @@ d_handle_option (size_t scode, const char *arg, int value,
       global.params.useOut = value;
       break;
 
+    case OPT_fparse_threads_:
+      parse_threads = value;
+      break;
+
     case OPT_fproperty:
       global.params.enforcePropertySyntax = value;
       break;
@@ -812,6 +832,111 @@ deps_write (Module *m)
   ob->writenl();
 }
 
+#ifdef HAVE_D_PTHREAD
+/* Modules waiting to be parsed ahead by the worker threads, and the number
+   of threads busy parsing, which may add more.  */
+
+static Modules parse_queue;
+static size_t parse_next;
+static unsigned parse_active;
+static bool parse_imports;
+static pthread_mutex_t parse_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t parse_cond = PTHREAD_COND_INITIALIZER;
+
+/* Worker thread: parse the queued modules until there are none left and no
+   other thread can queue any more.  If parse_imports, the imports of each
+   module parsed are queued in turn.  */
+
+static void *
+d_parse_worker (void *)
+{
+  pthread_mutex_lock (&parse_lock);
+
+  while (1)
+    {
+      if (parse_next < parse_queue.dim)
+	{
+	  Module *m = parse_queue[parse_next++];
+	  parse_active++;
+	  pthread_mutex_unlock (&parse_lock);
+
+	  bool parsed = m->parseAhead ();
+
+	  pthread_mutex_lock (&parse_lock);
+	  if (parsed && parse_imports)
+	    m->importsAhead (&parse_queue);
+	  parse_active--;
+	  pthread_cond_broadcast (&parse_cond);
+	}
+      else if (parse_active)
+	pthread_cond_wait (&parse_cond, &parse_lock);
+      else
+	break;
+    }
+
+  pthread_mutex_unlock (&parse_lock);
+  mem_endthread ();
+  return NULL;
+}
+
+/* Run parse_threads worker threads until parse_queue is done.  */
+
+static void
+d_parse_queue (void)
+{
+  pthread_t *threads = XNEWVEC (pthread_t, parse_threads);
+  unsigned nthreads = 0;
+
+  while (nthreads < parse_threads
+	 && pthread_create (&threads[nthreads], NULL, d_parse_worker, NULL) == 0)
+    nthreads++;
+
+  for (unsigned i = 0; i < nthreads; i++)
+    pthread_join (threads[i], NULL);
+
+  XDELETEVEC (threads);
+}
+
+/* Parse the root MODULES, and the modules they import, on parse_threads
+   worker threads.  Module::parse then only has to finish them off, in
+   the same order as it would parse them otherwise.  Anything that could
+   not be parsed ahead is parsed there as usual.  */
+
+static void
+d_parse_ahead (Modules *modules)
+{
+  for (size_t i = 0; i < modules->dim; i++)
+    {
+      Module *m = (*modules)[i];
+      m->markAhead ();
+      parse_queue.push (m);
+    }
+
+  parse_imports = false;
+  d_parse_queue ();
+
+  /* An import of a root module's name resolves to the root module, not to
+     a file; compiling object itself is one such case.  So the imports can
+     only be parsed ahead once the names of all the roots are known.  */
+  for (size_t i = 0; i < modules->dim; i++)
+    {
+      if (!(*modules)[i]->rootAhead ())
+	return;
+    }
+
+  // Every module imports object.
+  Module *mobject = Module::loadAhead (NULL, Id::object);
+  if (mobject)
+    parse_queue.push (mobject);
+
+  for (size_t i = 0; i < modules->dim; i++)
+    (*modules)[i]->importsAhead (&parse_queue);
+
+  parse_imports = true;
+  d_parse_queue ();
+}
+#endif
+
 void
 d_parse_file (void)
 {
@@ -918,6 +1043,11 @@ d_parse_file (void)
       m->read (Loc());
     }
 
+#ifdef HAVE_D_PTHREAD
+  if (parse_threads)
+    d_parse_ahead (&modules);
+#endif
+
   // Parse files
   for (size_t i = 0; i < modules.dim; i++)
     {
@@ -1132,6 +1262,15 @@ d_parse_file (void)
 	}
     }
 
+  if (global.params.verbose)
+    {
+      Lexer::stringtable.printStats (global.stdmsg, "identifiers");
+      Type::stringtable.printStats (global.stdmsg, "types");
+      fprintf (global.stdmsg, "dircache  %u directories read, %u file probes avoided\n",
+	       FileName::dirCacheReads, FileName::dirCacheHits);
+      mem_printstats (global.stdmsg);
+    }
+
   // And end the main input file, if the debug writer wants it.
   if (debug_hooks->start_end_main_source_file)
     (*debug_hooks->end_source_file) (0);
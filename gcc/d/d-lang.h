@@ -135,6 +135,8 @@ enum d_tree_index
   DTI_CONST_STRING_TYPE,
   DTI_NULL,
 
+  DTI_APPEND_CACHE,
+
   DTI_MAX
 };
 
@@ -160,6 +162,8 @@ extern GTY(()) tree d_global_trees[DTI_MAX];
 #define const_string_type_node		d_global_trees[DTI_CONST_STRING_TYPE]
 #define null_node			d_global_trees[DTI_NULL]
 
+#define d_append_cache_node		d_global_trees[DTI_APPEND_CACHE]
+
 
 /* In d-lang.cc.  These are called through function pointers
    and do not need to be "extern C". */
@@ -47,6 +47,9 @@ static Symbol *build_unittest_function (const char *, vec<FuncDeclaration *>);
 
 Symbol::Symbol (void)
 {
+  // Symbols are cached in declarations, so CTFE can't release its memory.
+  mem_pinregion();
+
   this->Sident = NULL;
   this->prettyIdent = NULL;
 
@@ -351,16 +354,8 @@ Lhaspointers:
     dt_cons (&dt, d_null_pointer);
 
   // xgetRTInfo*
-  if (getRTInfo)
-    getRTInfo->toDt (&dt);
-  else
-    {
-      // If class has no pointers.
-      if (flags & ClassFlags::noPointers)
-    	dt_cons (&dt, size_int (0));
-      else
-	dt_cons (&dt, size_int (1));
-    }
+  // The layout is described by the compiler, not the RTInfo template.
+  dt_cons (&dt, build_rtinfo_bitmap (this));
 
   /* Put out (*vtblInterfaces)[]. Must immediately follow csym.
    * The layout is:
@@ -1007,6 +1002,72 @@ Module::genmoduleinfo()
   build_moduleinfo (msym);
 }
 
+// Set importsRoot on every module that transitively imports a root module.
+// The import graph is walked backwards from the root modules once, rather
+// than searching forwards from each instantiating module.  It only needs
+// redoing if more modules have been loaded since it last ran.
+
+static void
+mark_root_importers (void)
+{
+  static size_t nmodules = 0;
+  size_t dim = Module::amodules.dim;
+
+  if (nmodules == dim)
+    return;
+
+  nmodules = dim;
+
+  // Number each module, then build the list of importers for each.
+  for (size_t i = 0; i < dim; i++)
+    {
+      Module *m = Module::amodules[i];
+      m->insearch = i;
+      m->importsRoot = false;
+    }
+
+  vec<Module *> *importers = XCNEWVEC (vec<Module *>, dim);
+  vec<Module *> worklist = vNULL;
+
+  for (size_t i = 0; i < dim; i++)
+    {
+      Module *m = Module::amodules[i];
+      for (size_t j = 0; j < m->aimports.dim; j++)
+	{
+	  Module *mi = m->aimports[j];
+	  if ((size_t) mi->insearch < dim && Module::amodules[mi->insearch] == mi)
+	    importers[mi->insearch].safe_push (m);
+	}
+
+      if (m->isRoot())
+	worklist.safe_push (m);
+    }
+
+  while (!worklist.is_empty())
+    {
+      Module *m = worklist.pop();
+      vec<Module *> &list = importers[m->insearch];
+
+      for (size_t i = 0; i < list.length(); i++)
+	{
+	  if (!list[i]->importsRoot)
+	    {
+	      list[i]->importsRoot = true;
+	      worklist.safe_push (list[i]);
+	    }
+	}
+    }
+
+  for (size_t i = 0; i < dim; i++)
+    {
+      Module::amodules[i]->insearch = 0;
+      importers[i].release();
+    }
+
+  worklist.release();
+  XDELETEVEC (importers);
+}
+
 // Returns TRUE if we want to compile the instantiated template TI.
 
 static bool
@@ -1022,33 +1083,11 @@ output_template_p (TemplateInstance *ti)
       && ti->instantiatingModule
       && !ti->instantiatingModule->isRoot())
     {
-      Module *mi = ti->instantiatingModule;
-      bool importsRoot = false;
-
       // If mi imports any root modules, we still need to generate the code.
-      for (size_t i = 0; i < Module::amodules.dim; ++i)
-	{
-	  Module *m = Module::amodules[i];
-	  m->insearch = 0;
-	}
-
-      for (size_t i = 0; i < Module::amodules.dim; ++i)
-	{
-	  Module *m = Module::amodules[i];
-	  if (m->isRoot() && mi->imports(m))
-	    {
-	      importsRoot = true;
-	      break;
-	    }
-	}
-
-      for (size_t i = 0; i < Module::amodules.dim; ++i)
-	{
-	  Module *m = Module::amodules[i];
-	  m->insearch = 0;
-	}
+      Module *mi = ti->instantiatingModule;
+      mark_root_importers();
 
-      if (!importsRoot)
+      if (!mi->importsRoot)
 	return false;
     }
 
@@ -1420,6 +1459,13 @@ FuncDeclaration::buildClosure (IRState *irs)
       DECL_NAME (decl) = get_identifier ("__closptr");
       decl_ref = build_deref (decl);
 
+      if (global.params.vclosure)
+	{
+	  char *p = loc.toChars();
+	  fprintf (global.stdmsg, "%s: %s allocates a closure on the heap, %s\n",
+		   p ? p : "", toPrettyChars(), closureReason ? closureReason : "");
+	}
+
       // Allocate memory for closure.
       tree arg = convert (Type::tsize_t->toCtype(),
 			  TYPE_SIZE_UNIT (type));
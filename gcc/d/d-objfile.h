@@ -87,6 +87,8 @@ extern dt_t **dt_container (dt_t **pdt, Type *type, dt_t *dt);
 extern dt_t **build_vptr_monitor (dt_t **pdt, ClassDeclaration *cd);
 
 extern tree dtvector_to_tree (dt_t *dt);
+extern tree build_static_aa_impl (AssocArrayLiteralExp *aale, TypeAArray *aatype);
+extern tree build_rtinfo_bitmap (AggregateDeclaration *ad);
 
 extern void build_moduleinfo (Symbol *sym);
 
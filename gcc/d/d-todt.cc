@@ -183,6 +183,594 @@ dtvector_to_tree (dt_t *dt)
   return dt_container2 (dt);
 }
 
+// Array literals of at least this many scalar constants are written out as
+// a single STRING_CST holding their target representation, rather than as
+// a CONSTRUCTOR with a tree for every element.
+
+#define DT_BLOB_MIN_ELEMENTS 64
+
+// Return a new CONSTRUCTOR of the static array type TYPE with the values ELTS.
+
+static tree
+dt_array_ctor (tree type, vec<constructor_elt, va_gc> *elts)
+{
+  tree ctor = build_constructor (type, elts);
+  TREE_CONSTANT (ctor) = 1;
+  TREE_READONLY (ctor) = 1;
+  TREE_STATIC (ctor) = 1;
+  return ctor;
+}
+
+// Append VALUE for the array elements LWR up to UPR onto ELTS as one
+// RANGE_EXPR.  Zero values are left out, the gaps are zero filled.
+
+static void
+dt_array_fill (vec<constructor_elt, va_gc> **elts, tree value,
+	       size_t lwr, size_t upr)
+{
+  if (lwr >= upr || initializer_zerop (value))
+    return;
+
+  tree index = size_int (lwr);
+  if (upr - lwr > 1)
+    index = build2 (RANGE_EXPR, sizetype, index, size_int (upr - 1));
+
+  CONSTRUCTOR_APPEND_ELT (*elts, index, value);
+}
+
+// If DT holds exactly one value with the size of ETYPE, return it.
+// Otherwise return NULL_TREE.
+
+static tree
+dt_single_value (dt_t *dt, tree etype)
+{
+  if (dt == NULL_TREE || CONSTRUCTOR_NELTS (dt) != 1)
+    return NULL_TREE;
+
+  tree value = CONSTRUCTOR_ELT (dt, 0)->value;
+  if (!tree_int_cst_equal (TYPE_SIZE_UNIT (TREE_TYPE (value)),
+			   TYPE_SIZE_UNIT (etype)))
+    return NULL_TREE;
+
+  return value;
+}
+
+// Return a STRING_CST holding the target representation of the scalar
+// constant ELEMENTS of type TELEM, or NULL_TREE if any element is not an
+// integer, floating point or complex constant.
+
+static tree
+dt_array_blob (Type *telem, Expressions *elements)
+{
+  Type *tb = telem->toBasetype();
+  if (!(tb->isintegral() || tb->isfloating()) || tb->ty == Tvector)
+    return NULL_TREE;
+
+  tree type = tb->toCtype();
+  size_t esize = tb->size();
+  size_t length = elements->dim * esize;
+  unsigned char *buffer = XCNEWVEC (unsigned char, length);
+  tree value = NULL_TREE;
+
+  for (size_t i = 0; i < elements->dim; i++)
+    {
+      Expression *e = (*elements)[i];
+      if (e->op != TOKint64 && e->op != TOKfloat64 && e->op != TOKcomplex80)
+	goto Lfail;
+
+      tree cst = fold_convert (type, e->toElem (NULL));
+      if (!CONSTANT_CLASS_P (cst)
+	  || native_encode_expr (cst, buffer + i * esize, esize) != (int) esize)
+	goto Lfail;
+    }
+
+  value = build_string (length, (char *) buffer);
+  TREE_TYPE (value) = d_array_type (telem, elements->dim);
+  TREE_CONSTANT (value) = 1;
+  TREE_READONLY (value) = 1;
+
+ Lfail:
+  XDELETEVEC (buffer);
+  return value;
+}
+
+// The bucket counts used by the runtime, from rt/aaA.d.
+
+static const dinteger_t dt_aa_primes[] =
+{
+  31UL, 97UL, 389UL, 1543UL, 6151UL, 24593UL, 98317UL,
+  393241UL, 1572869UL, 6291469UL, 25165843UL, 100663319UL,
+  402653189UL, 1610612741UL, 4294967291UL,
+};
+
+// Return the result of rt.util.hash.hashOf for the LEN bytes at DATA,
+// truncated to the target size_t by MASK.
+
+static dinteger_t
+dt_hash_of (const unsigned char *data, size_t len, dinteger_t mask)
+{
+  dinteger_t hash = 0;
+  size_t rem = len & 3;
+
+  if (len == 0)
+    return 0;
+
+  for (len >>= 2; len > 0; len--)
+    {
+      hash = (hash + (data[0] | (data[1] << 8))) & mask;
+      dinteger_t tmp = ((dinteger_t) (data[2] | (data[3] << 8)) << 11) ^ hash;
+      hash = ((hash << 16) ^ tmp) & mask;
+      data += 4;
+      hash = (hash + (hash >> 11)) & mask;
+    }
+
+  switch (rem)
+    {
+    case 3:
+      hash = (hash + (data[0] | (data[1] << 8))) & mask;
+      hash = (hash ^ (hash << 16)) & mask;
+      hash ^= (dinteger_t) data[2] << 18;
+      hash = (hash + (hash >> 11)) & mask;
+      break;
+
+    case 2:
+      hash = (hash + (data[0] | (data[1] << 8))) & mask;
+      hash = (hash ^ (hash << 11)) & mask;
+      hash = (hash + (hash >> 17)) & mask;
+      break;
+
+    case 1:
+      hash = (hash + data[0]) & mask;
+      hash = (hash ^ (hash << 10)) & mask;
+      hash = (hash + (hash >> 1)) & mask;
+      break;
+    }
+
+  hash = (hash ^ (hash << 3)) & mask;
+  hash = (hash + (hash >> 5)) & mask;
+  hash = (hash ^ (hash << 4)) & mask;
+  hash = (hash + (hash >> 17)) & mask;
+  hash = (hash ^ (hash << 25)) & mask;
+  hash = (hash + (hash >> 6)) & mask;
+
+  return hash;
+}
+
+// Set PHASH to the hash that the TypeInfo of keys of KIND computes at
+// runtime for the constant key E.  Returns false if E is not a constant
+// whose hash is known at compile time.
+
+static bool
+dt_aa_key_hash (Expression *e, AAKeyKind kind, dinteger_t *phash)
+{
+  dinteger_t mask = Target::ptrsize == 8 ? ~(dinteger_t) 0 : 0xffffffff;
+
+  switch (kind)
+    {
+    case AAKEY_INT32:
+      if (e->op != TOKint64)
+	return false;
+      *phash = e->toInteger() & 0xffffffff;
+      return true;
+
+    case AAKEY_INT64:
+      {
+	unsigned char buffer[8];
+	if (e->op != TOKint64)
+	  return false;
+
+	tree cst = build_integer_cst (e->toInteger(), Type::tuns64->toCtype());
+	if (native_encode_expr (cst, buffer, 8) != 8)
+	  return false;
+
+	*phash = dt_hash_of (buffer, 8, mask);
+	return true;
+      }
+
+    case AAKEY_STRING:
+      {
+	if (e->op != TOKstring || ((StringExp *) e)->sz != 1)
+	  return false;
+
+	StringExp *se = (StringExp *) e;
+	const unsigned char *s = (const unsigned char *) se->string;
+	dinteger_t hash = 0;
+
+	for (size_t i = 0; i < se->len; i++)
+	  hash = (hash * 11 + s[i]) & mask;
+
+	*phash = hash;
+	return true;
+      }
+
+    default:
+      // Pointer keys are not known until link time.
+      return false;
+    }
+}
+
+// Return true if the constant keys E1 and E2 of KIND are equal.
+
+static bool
+dt_aa_key_equals (Expression *e1, Expression *e2, AAKeyKind kind)
+{
+  if (kind == AAKEY_STRING)
+    {
+      StringExp *se1 = (StringExp *) e1;
+      StringExp *se2 = (StringExp *) e2;
+      return se1->len == se2->len && memcmp (se1->string, se2->string, se1->len) == 0;
+    }
+
+  dinteger_t mask = kind == AAKEY_INT32 ? 0xffffffff : ~(dinteger_t) 0;
+  return (e1->toInteger() & mask) == (e2->toInteger() & mask);
+}
+
+// Return true if E is a constant that can be written to static data
+// without referring to anything that only exists at runtime.
+
+static bool
+dt_constant_value_p (Expression *e)
+{
+  switch (e->op)
+    {
+    case TOKint64:
+    case TOKfloat64:
+    case TOKcomplex80:
+    case TOKstring:
+    case TOKnull:
+      return true;
+
+    case TOKarrayliteral:
+      {
+	Expressions *elements = ((ArrayLiteralExp *) e)->elements;
+	for (size_t i = 0; i < elements->dim; i++)
+	  {
+	    if (!dt_constant_value_p ((*elements)[i]))
+	      return false;
+	  }
+	return true;
+      }
+
+    case TOKstructliteral:
+      {
+	Expressions *elements = ((StructLiteralExp *) e)->elements;
+	for (size_t i = 0; i < elements->dim; i++)
+	  {
+	    Expression *elem = (*elements)[i];
+	    if (elem && !dt_constant_value_p (elem))
+	      return false;
+	  }
+	return true;
+      }
+
+    default:
+      return false;
+    }
+}
+
+// Lay out the associative array literal AALE of type AATYPE in read-only
+// static data, in the bucket and entry format built by the runtime function
+// _d_assocarrayliteralTX in rt/aaA.d.  Returns the address of the Impl, or
+// NULL_TREE if any key or value is not a constant whose layout and hash are
+// known at compile time.
+
+tree
+build_static_aa_impl (AssocArrayLiteralExp *aale, TypeAArray *aatype)
+{
+  Expressions *keys = aale->keys;
+  Expressions *values = aale->values;
+  AAKeyKind kind = aa_key_kind (aatype->index);
+  Type *tvalue = aatype->next;
+
+  if (kind == AAKEY_GENERIC || keys->dim == 0 || tvalue->size() == 0)
+    return NULL_TREE;
+
+  // Work out the hash of every key, and the last value for each of them.
+  dinteger_t *hashes = XNEWVEC (dinteger_t, keys->dim);
+  size_t *slots = XNEWVEC (size_t, keys->dim);
+  size_t nodes = 0;
+  tree impl = NULL_TREE;
+
+  for (size_t i = 0; i < keys->dim; i++)
+    {
+      if (!dt_aa_key_hash ((*keys)[i], kind, &hashes[i])
+	  || !dt_constant_value_p ((*values)[i]))
+	goto Lfail;
+
+      slots[i] = i;
+      for (size_t j = 0; j < i; j++)
+	{
+	  if (slots[j] == j && hashes[i] == hashes[j]
+	      && dt_aa_key_equals ((*keys)[i], (*keys)[j], kind))
+	    {
+	      slots[i] = j;
+	      break;
+	    }
+	}
+
+      if (slots[i] == i)
+	nodes++;
+    }
+
+  {
+    size_t nprimes = sizeof (dt_aa_primes) / sizeof (dt_aa_primes[0]);
+    size_t p;
+    for (p = 0; p < nprimes - 1; p++)
+      {
+	if (nodes <= dt_aa_primes[p])
+	  break;
+      }
+    dinteger_t nbuckets = dt_aa_primes[p];
+
+    // Keys are padded to this size, see aligntsize in rt/aaA.d.
+    size_t keysize = aatype->index->size();
+    size_t align = Target::ptrsize == 8 ? 16 : Target::ptrsize;
+    size_t keypad = ((keysize + align - 1) & ~(align - 1)) - keysize;
+
+    tree ptrtype = Type::tvoidptr->toCtype();
+    tree *buckets = XCNEWVEC (tree, nbuckets);
+
+    // The runtime appends each new key to the end of its bucket's chain,
+    // so build the entries last to first, linking each to the next.
+    for (size_t i = keys->dim; i-- > 0; )
+      {
+	if (slots[i] != i)
+	  continue;
+
+	// The value is the last one given for this key.
+	Expression *value = (*values)[i];
+	for (size_t j = i + 1; j < keys->dim; j++)
+	  {
+	    if (slots[j] == i)
+	      value = (*values)[j];
+	  }
+
+	dinteger_t bucket = hashes[i] % nbuckets;
+	tree dt = NULL_TREE;
+
+	/* Put out:
+	 *  Entry *next;
+	 *  size_t hash;
+	 *  key, padded to aligntsize;
+	 *  value;
+	 */
+	dt_cons (&dt, buckets[bucket] ? buckets[bucket] : d_null_pointer);
+	dt_cons (&dt, build_integer_cst (hashes[i], Type::tsize_t->toCtype()));
+	(*keys)[i]->toDt (&dt);
+	if (keypad)
+	  dt_zeropad (&dt, keypad);
+
+	Type *tb = tvalue->toBasetype();
+	if (tb->ty == Tsarray)
+	  ((TypeSArray *) tb)->toDtElem (&dt, value);
+	else
+	  value->toDt (&dt);
+
+	Symbol *s = new Symbol();
+	s->Sdt = dt;
+	s->Sreadonly = true;
+	d_finish_symbol (s);
+
+	buckets[bucket] = build_nop (ptrtype, build_address (s->Stree));
+      }
+
+    // Buckets without entries are zero filled.
+    vec<constructor_elt, va_gc> *elts = NULL;
+    for (dinteger_t i = 0; i < nbuckets; i++)
+      {
+	if (buckets[i] != NULL_TREE)
+	  CONSTRUCTOR_APPEND_ELT (elts, size_int (i), buckets[i]);
+      }
+    XDELETEVEC (buckets);
+
+    Symbol *sbuckets = new Symbol();
+    sbuckets->Sdt = NULL_TREE;
+    dt_cons (&sbuckets->Sdt, dt_array_ctor (d_array_type (Type::tvoidptr, nbuckets), elts));
+    sbuckets->Sreadonly = true;
+    d_finish_symbol (sbuckets);
+
+    /* Put out:
+     *  Entry*[] buckets;
+     *  size_t nodes;
+     *  TypeInfo _keyti;
+     *  Entry*[4] binit;
+     */
+    aatype->index->getTypeInfo (NULL);
+
+    tree dt = NULL_TREE;
+    dt_cons (&dt, size_int (nbuckets));
+    dt_cons (&dt, build_address (sbuckets->Stree));
+    dt_cons (&dt, size_int (nodes));
+    dt_cons (&dt, build_address (aatype->index->vtinfo->toSymbol()->Stree));
+    dt_zeropad (&dt, 4 * Target::ptrsize);
+
+    Symbol *simpl = new Symbol();
+    simpl->Sdt = dt;
+    simpl->Sreadonly = true;
+    d_finish_symbol (simpl);
+
+    impl = build_address (simpl->Stree);
+  }
+
+ Lfail:
+  XDELETEVEC (hashes);
+  XDELETEVEC (slots);
+  return impl;
+}
+
+// Set the bit in BITMAP for each pointer-sized word of a value of TYPE at
+// byte OFFSET that may hold a reference into GC memory.  Returns false if a
+// reference is not aligned to a word, and so can't be described.
+
+static bool
+dt_pointer_bitmap (Type *type, dinteger_t offset, bool *bitmap)
+{
+  Type *tb = type->toBasetype();
+  size_t ptrsize = Target::ptrsize;
+
+  if (!tb->hasPointers())
+    return true;
+
+  switch (tb->ty)
+    {
+    case Tpointer:
+    case Tnull:
+    case Tclass:
+    case Taarray:
+      // The context pointer of a delegate comes first.
+    case Tdelegate:
+      if (offset % ptrsize)
+	return false;
+      bitmap[offset / ptrsize] = true;
+      return true;
+
+    case Tarray:
+      // Only the ptr field of the array.
+      offset += ptrsize;
+      if (offset % ptrsize)
+	return false;
+      bitmap[offset / ptrsize] = true;
+      return true;
+
+    case Tsarray:
+      {
+	Type *telem = tb->nextOf()->toBasetype();
+	dinteger_t dim = ((TypeSArray *) tb)->dim->toInteger();
+	dinteger_t esize = telem->size();
+
+	if (telem->ty != Tvoid)
+	  {
+	    for (dinteger_t i = 0; i < dim; i++)
+	      {
+		if (!dt_pointer_bitmap (telem, offset + i * esize, bitmap))
+		  return false;
+	      }
+	    return true;
+	  }
+	// Nothing is known about the contents of a void[N], fall through.
+	break;
+      }
+
+    case Tstruct:
+      {
+	StructDeclaration *sd = ((TypeStruct *) tb)->sym;
+	for (size_t i = 0; i < sd->fields.dim; i++)
+	  {
+	    VarDeclaration *v = sd->fields[i];
+	    if (!dt_pointer_bitmap (v->type, offset + v->offset, bitmap))
+	      return false;
+	  }
+	return true;
+      }
+
+    default:
+      break;
+    }
+
+  // Scan every word that overlaps the value.
+  dinteger_t size = tb->size();
+  if (size == 0)
+    return true;
+
+  for (dinteger_t i = offset / ptrsize; i <= (offset + size - 1) / ptrsize; i++)
+    bitmap[i] = true;
+
+  return true;
+}
+
+// Build the pointer bitmap used by the precise GC to scan instances of the
+// struct or class AD, returning the value to put out for xgetRTInfo.  This
+// is zero if AD has no pointers, one if it must be scanned conservatively,
+// or the address of a read-only size_t[] holding the size of AD in bytes,
+// rounded up to a whole word for classes, followed by one bit per word, set for each word that may be a pointer.
+
+tree
+build_rtinfo_bitmap (AggregateDeclaration *ad)
+{
+  ClassDeclaration *cd = ad->isClassDeclaration();
+  size_t ptrsize = Target::ptrsize;
+  size_t bits_per_word = ptrsize * BITS_PER_UNIT;
+  dinteger_t size = ad->structsize;
+
+  if (cd != NULL)
+    {
+      bool pointers = false;
+      for (ClassDeclaration *c = cd; c != NULL; c = c->baseClass)
+	{
+	  for (size_t i = 0; i < c->fields.dim && !pointers; i++)
+	    pointers = c->fields[i]->hasPointers();
+	}
+
+      if (!pointers)
+	return size_int (0);
+    }
+  else if (!ad->type->hasPointers())
+    return size_int (0);
+
+  // Don't bother describing very large aggregates.
+  dinteger_t nwords = (size + ptrsize - 1) / ptrsize;
+  if (nwords == 0 || nwords > 0x10000)
+    return size_int (1);
+
+  // Unlike structs, class instances need not end on a whole word, which
+  // the GC would take as a layout it can't describe.  Round the size up,
+  // the padding holds no pointers.
+  if (cd != NULL)
+    size = nwords * ptrsize;
+
+  bool *bitmap = XCNEWVEC (bool, nwords);
+  bool precise = true;
+
+  if (cd != NULL)
+    {
+      // The __vptr and __monitor are never scanned, fields of base classes
+      // come before those of derived classes.
+      for (ClassDeclaration *c = cd; c != NULL && precise; c = c->baseClass)
+	{
+	  for (size_t i = 0; i < c->fields.dim && precise; i++)
+	    {
+	      VarDeclaration *v = c->fields[i];
+	      precise = dt_pointer_bitmap (v->type, v->offset, bitmap);
+	    }
+	}
+    }
+  else
+    precise = dt_pointer_bitmap (ad->type, 0, bitmap);
+
+  if (!precise)
+    {
+      XDELETEVEC (bitmap);
+      return size_int (1);
+    }
+
+  /* Put out:
+   *  size_t size;
+   *  size_t[] bits;
+   */
+  tree size_type = Type::tsize_t->toCtype();
+  tree dt = NULL_TREE;
+  dt_cons (&dt, build_integer_cst (size, size_type));
+
+  for (dinteger_t i = 0; i < nwords; i += bits_per_word)
+    {
+      dinteger_t word = 0;
+      for (dinteger_t j = 0; j < bits_per_word && i + j < nwords; j++)
+	{
+	  if (bitmap[i + j])
+	    word |= (dinteger_t) 1 << j;
+	}
+      dt_cons (&dt, build_integer_cst (word, size_type));
+    }
+  XDELETEVEC (bitmap);
+
+  Symbol *s = new Symbol();
+  s->Sdt = dt;
+  s->Sreadonly = true;
+  d_finish_symbol (s);
+
+  return build_address (s->Stree);
+}
+
 // Put out __vptr and __monitor of class CD into PDT.
 
 dt_t **
@@ -265,25 +853,73 @@ ArrayInitializer::toDt (void)
       edefault->toDt (&sadefault);
     }
 
-  tree dt = NULL_TREE;
-  for (size_t i = 0; i < dim; i++)
-    dt_chainon (&dt, dts[i] ? dts[i] : sadefault);
-
+  size_t tadim = dim;
   if (tb->ty == Tsarray)
     {
       TypeSArray *ta = (TypeSArray *) tb;
-      size_t tadim = ta->dim->toInteger();
+      tadim = ta->dim->toInteger();
+
+      if (dim > tadim)
+	{
+	  error (loc, "too many initializers, %d, for array[%d]", dim, tadim);
+	  tadim = dim;
+	}
+    }
+
+  // If every element is a single value, build the array directly with
+  // each run of default initialisers as one range.
+  tree etype = tb->nextOf()->toCtype();
+  tree defval = NULL_TREE;
+  bool single = false;
+
+  if (type->toBasetype()->ty != Tvector)
+    {
+      defval = dt_single_value (sadefault, etype);
+      single = (defval != NULL_TREE);
+    }
+
+  for (size_t i = 0; single && i < dim; i++)
+    {
+      if (dts[i] && !dt_single_value (dts[i], etype))
+	single = false;
+    }
+
+  tree dt = NULL_TREE;
+  if (single)
+    {
+      vec<constructor_elt, va_gc> *elts = NULL;
+      size_t lwr = 0;
 
-      if (dim < tadim)
+      for (size_t i = 0; i < dim; i++)
 	{
-	  // Pad out the rest of the array.
-	  for (size_t i = dim; i < tadim; i++)
-	    dt_chainon (&dt, sadefault);
+	  if (!dts[i])
+	    continue;
+
+	  dt_array_fill (&elts, defval, lwr, i);
+	  CONSTRUCTOR_APPEND_ELT (elts, size_int (i),
+				  CONSTRUCTOR_ELT (dts[i], 0)->value);
+	  lwr = i + 1;
 	}
-      else if (dim > tadim)
-	error (loc, "too many initializers, %d, for array[%d]", dim, tadim);
+      dt_array_fill (&elts, defval, lwr, tadim);
+
+      tree atype = (tb->ty == Tsarray)
+	? type->toCtype() : d_array_type (tb->nextOf(), dim);
+      dt_cons (&dt, dt_array_ctor (atype, elts));
+
+      if (tb->ty == Tsarray)
+	return dt;
     }
   else
+    {
+      for (size_t i = 0; i < dim; i++)
+	dt_chainon (&dt, dts[i] ? dts[i] : sadefault);
+
+      // Pad out the rest of the array.
+      for (size_t i = dim; i < tadim; i++)
+	dt_chainon (&dt, sadefault);
+    }
+
+  if (tb->ty != Tsarray)
     {
       gcc_assert (tb->ty == Tarray || tb->ty == Tpointer);
 
@@ -364,15 +1000,30 @@ StringExp::toDt (dt_t **pdt)
 dt_t **
 ArrayLiteralExp::toDt (dt_t **pdt)
 {
+  Type *tb = type->toBasetype();
   tree dt = NULL_TREE;
+  tree blob = NULL_TREE;
 
-  for (size_t i = 0; i < elements->dim; i++)
+  if (elements->dim >= DT_BLOB_MIN_ELEMENTS)
+    blob = dt_array_blob (tb->nextOf(), elements);
+
+  if (blob != NULL_TREE)
     {
-      Expression *e = (*elements)[i];
-      e->toDt (&dt);
+      if (tb->ty == Tsarray)
+	{
+	  TREE_TYPE (blob) = type->toCtype();
+	  return dt_cons (pdt, blob);
+	}
+      dt_cons (&dt, blob);
+    }
+  else
+    {
+      for (size_t i = 0; i < elements->dim; i++)
+	{
+	  Expression *e = (*elements)[i];
+	  e->toDt (&dt);
+	}
     }
-
-  Type *tb = type->toBasetype();
 
   if (tb->ty != Tsarray)
     {
@@ -394,6 +1045,32 @@ ArrayLiteralExp::toDt (dt_t **pdt)
   return pdt;
 }
 
+dt_t **
+AssocArrayLiteralExp::toDt (dt_t **pdt)
+{
+  Type *tb = type->toBasetype();
+
+  // Only immutable literals can share one static copy.
+  if (tb->ty != Taarray || !type->isImmutable())
+    return Expression::toDt (pdt);
+
+  TypeAArray *aatype = (TypeAArray *) tb->mutableOf();
+  tree impl = build_static_aa_impl (this, aatype);
+
+  if (impl == NULL_TREE)
+    return Expression::toDt (pdt);
+
+  tree aat_type = aatype->toCtype();
+  vec<constructor_elt, va_gc> *ce = NULL;
+  CONSTRUCTOR_APPEND_ELT (ce, TYPE_FIELDS (aat_type),
+			  build_nop (TREE_TYPE (TYPE_FIELDS (aat_type)), impl));
+  tree dt = build_constructor (aat_type, ce);
+  TREE_CONSTANT (dt) = 1;
+  TREE_STATIC (dt) = 1;
+
+  return dt_cons (pdt, dt);
+}
+
 dt_t **
 StructLiteralExp::toDt (dt_t **pdt)
 {
@@ -948,8 +1625,7 @@ TypeSArray::toDtElem (dt_t **pdt, Expression *e)
 	  else if (e->op == TOKarrayliteral)
 	    len /= ((ArrayLiteralExp *) e)->elements->dim;
 
-	  for (size_t i = 0; i < len; i++)
-	    e->toDt (&dt);
+	  e->toDt (&dt);
 
 	  // Single initialiser already constructed, just chain onto pdt.
 	  if (len == 1)
@@ -961,16 +1637,26 @@ TypeSArray::toDtElem (dt_t **pdt, Expression *e)
 	  if (!e)
 	    e = tnext->defaultInit();
 
-	  for (size_t i = 0; i < len; i++)
-	    {
-	      if (tbn->ty == Tsarray)
-		((TypeSArray *) tbn)->toDtElem (&dt, e);
-	      else
-    		e->toDt (&dt);
-	    }
+	  if (tbn->ty == Tsarray)
+	    ((TypeSArray *) tbn)->toDtElem (&dt, e);
+	  else
+	    e->toDt (&dt);
 	}
 
-      return dt_container (pdt, this, dt);
+      // Every element has the same value, so emit it once as a range.
+      tree value = dt_single_value (dt, next->toCtype());
+      if (value != NULL_TREE && len == dim->toInteger())
+	{
+	  vec<constructor_elt, va_gc> *elts = NULL;
+	  dt_array_fill (&elts, value, 0, len);
+	  return dt_cons (pdt, dt_array_ctor (toCtype(), elts));
+	}
+
+      tree adt = NULL_TREE;
+      for (size_t i = 0; i < len; i++)
+	dt_chainon (&adt, dt);
+
+      return dt_container (pdt, this, adt);
     }
 
   return pdt;
@@ -1498,16 +2184,8 @@ TypeInfoStructDeclaration::toDt (dt_t **pdt)
     }
 
   // xgetRTInfo
-  if (sd->getRTInfo)
-    sd->getRTInfo->toDt (pdt);
-  else
-    {
-      // If struct has pointers.
-      if (m_flags & StructFlags::hasPointers)
-	dt_cons (pdt, size_int (1));
-      else
-	dt_cons (pdt, size_int (0));
-    }
+  // The layout is described by the compiler, not the RTInfo template.
+  dt_cons (pdt, build_rtinfo_bitmap (sd));
 }
 
 void
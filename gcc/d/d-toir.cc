@@ -294,6 +294,169 @@ CaseStatement::toIR (IRState *irs)
     statement->toIR (irs);
 }
 
+// Largest number of string cases to dispatch inline, anything bigger
+// is left to the binary search done by the _d_switch_string routines.
+
+#define STRING_SWITCH_INLINE_MAX 64
+
+// Return a comparison of the LEN characters at PTR against the case
+// string SE, which is of type ELEM_TYPE[].
+
+static tree
+build_string_case_cond (tree ptr, StringExp *se, Type *elem_type)
+{
+  tree value = build_string (se->len * se->sz, (char *) se->string);
+  TREE_TYPE (value) = d_array_type (elem_type, se->len);
+  TREE_CONSTANT (value) = 1;
+  TREE_READONLY (value) = 1;
+
+  tree tmemcmp = d_build_call_nary (builtin_decl_explicit (BUILT_IN_MEMCMP), 3,
+				    ptr, build_address (value),
+				    size_int (se->len * se->sz));
+
+  return build_boolop (EQ_EXPR, tmemcmp, integer_zero_node);
+}
+
+// Add to the current statement list the tests for the sorted case strings
+// CASES[LWR .. UPR), which all have the same length.  A matching case sets
+// INDEX to its position in CASES and jumps to ENDLABEL.
+
+static void
+build_string_case_tests (IRState *irs, tree ptr, tree index, tree endlabel,
+			 CaseStatements *cases, size_t lwr, size_t upr,
+			 Type *elem_type)
+{
+  StringExp *se = (StringExp *) (*cases)[lwr]->exp;
+
+  // Only one string can have a length of zero.
+  if (se->len == 0)
+    {
+      irs->addExp (vmodify_expr (index, build_integer_cst (lwr, TREE_TYPE (index))));
+      irs->addExp (build1 (GOTO_EXPR, void_type_node, endlabel));
+      return;
+    }
+
+  // With more than a couple of candidates, switch on the character that
+  // splits them into the most groups first, so that only strings agreeing
+  // at that position need to be compared.
+  size_t split = se->len;
+  size_t ngroups = 1;
+
+  if (upr - lwr > 2)
+    {
+      for (size_t pos = 0; pos < se->len; pos++)
+	{
+	  size_t count = 0;
+	  for (size_t i = lwr; i < upr; i++)
+	    {
+	      unsigned c = ((StringExp *) (*cases)[i]->exp)->charAt (pos);
+	      size_t j = lwr;
+	      while (j < i && ((StringExp *) (*cases)[j]->exp)->charAt (pos) != c)
+		j++;
+	      if (j == i)
+		count++;
+	    }
+
+	  if (count > ngroups)
+	    {
+	      split = pos;
+	      ngroups = count;
+	    }
+	}
+    }
+
+  if (ngroups == 1)
+    {
+      for (size_t i = lwr; i < upr; i++)
+	{
+	  tree cond = build_string_case_cond (ptr, (StringExp *) (*cases)[i]->exp,
+					      elem_type);
+	  tree match = vcompound_expr (vmodify_expr (index, build_integer_cst (i, TREE_TYPE (index))),
+				       build1 (GOTO_EXPR, void_type_node, endlabel));
+	  irs->addExp (build3 (COND_EXPR, void_type_node, cond, match, d_void_zero_node));
+	}
+      return;
+    }
+
+  tree chr = build_deref (build_array_index (ptr, size_int (split)));
+  irs->pushStatementList();
+
+  for (size_t i = lwr; i < upr; i++)
+    {
+      unsigned c = ((StringExp *) (*cases)[i]->exp)->charAt (split);
+      size_t j = lwr;
+      while (j < i && ((StringExp *) (*cases)[j]->exp)->charAt (split) != c)
+	j++;
+      if (j != i)
+	continue;
+
+      // Case labels for each distinct character, in order of first use.
+      tree label = d_build_label (Loc(), NULL);
+      irs->addExp (build_case_label (build_integer_cst (c, TREE_TYPE (chr)),
+				     NULL_TREE, label));
+      for (j = i; j < upr; j++)
+	{
+	  StringExp *sj = (StringExp *) (*cases)[j]->exp;
+	  if (sj->charAt (split) != c)
+	    continue;
+
+	  tree cond = build_string_case_cond (ptr, sj, elem_type);
+	  tree match = vcompound_expr (vmodify_expr (index, build_integer_cst (j, TREE_TYPE (index))),
+				       build1 (GOTO_EXPR, void_type_node, endlabel));
+	  irs->addExp (build3 (COND_EXPR, void_type_node, cond, match, d_void_zero_node));
+	}
+      irs->addExp (build1 (GOTO_EXPR, void_type_node, endlabel));
+    }
+
+  tree body = irs->popStatementList();
+  irs->addExp (build3 (SWITCH_EXPR, TREE_TYPE (chr), chr, body, NULL_TREE));
+}
+
+// Lower the switch on the string COND to an inline dispatch on its length,
+// followed by the tests from build_string_case_tests.  Returns the position
+// of the matching case in the sorted CASES, or -1 if there is none, the
+// same as the _d_switch_string library routines.
+
+static tree
+build_string_switch (IRState *irs, tree cond, CaseStatements *cases,
+		     Type *elem_type)
+{
+  tree var = build_local_temp (TREE_TYPE (cond));
+  tree index = build_local_temp (Type::tint32->toCtype());
+  tree endlabel = d_build_label (Loc(), NULL);
+
+  irs->addExp (build_vinit (var, cond));
+  irs->addExp (vmodify_expr (index, build_integer_cst (-1, TREE_TYPE (index))));
+
+  tree len = d_array_length (var);
+  tree ptr = d_array_ptr (var);
+  irs->pushStatementList();
+
+  // Cases are sorted by length first, so each length is a single run.
+  for (size_t lwr = 0; lwr < cases->dim; )
+    {
+      StringExp *se = (StringExp *) (*cases)[lwr]->exp;
+      size_t upr = lwr + 1;
+      while (upr < cases->dim && ((StringExp *) (*cases)[upr]->exp)->len == se->len)
+	upr++;
+
+      tree label = d_build_label (Loc(), NULL);
+      irs->addExp (build_case_label (build_integer_cst (se->len, TREE_TYPE (len)),
+				     NULL_TREE, label));
+      build_string_case_tests (irs, ptr, index, endlabel, cases, lwr, upr, elem_type);
+      irs->addExp (build1 (GOTO_EXPR, void_type_node, endlabel));
+      lwr = upr;
+    }
+
+  tree body = irs->popStatementList();
+  irs->addExp (build3 (SWITCH_EXPR, TREE_TYPE (len), len, body, NULL_TREE));
+
+  TREE_USED (endlabel) = 1;
+  irs->doLabel (endlabel);
+
+  return index;
+}
+
 void
 SwitchStatement::toIR (IRState *irs)
 {
@@ -330,30 +493,47 @@ SwitchStatement::toIR (IRState *irs)
       // on the case array, have to change them to be useable.
       cases->sort();
 
-      tree args[2];
-      Symbol *s = new Symbol();
-      dt_t **pdt = &s->Sdt;
-
+      bool all_strings = true;
       for (size_t i = 0; i < cases->dim; i++)
 	{
 	  CaseStatement *cs = (*cases)[i];
 	  cs->index = i;
 
 	  if (cs->exp->op != TOKstring)
-	    error("case '%s' is not a string", cs->exp->toChars());
-	  else
-	    pdt = cs->exp->toDt (pdt);
+	    {
+	      error("case '%s' is not a string", cs->exp->toChars());
+	      all_strings = false;
+	    }
 	}
 
-      s->Sreadonly = true;
-      d_finish_symbol (s);
+      // Small sets of case strings are matched inline, which saves both
+      // the library call and the table of strings it searches.
+      if (all_strings && !optimize_size
+	  && cases->dim <= STRING_SWITCH_INLINE_MAX)
+	cond_tree = build_string_switch (irs, cond_tree, cases, elem_type);
+      else
+	{
+	  tree args[2];
+	  Symbol *s = new Symbol();
+	  dt_t **pdt = &s->Sdt;
 
-      args[0] = d_array_value (cond_type->arrayOf()->toCtype(),
-			       size_int (cases->dim),
-			       build_address (s->Stree));
-      args[1] = cond_tree;
+	  for (size_t i = 0; i < cases->dim; i++)
+	    {
+	      CaseStatement *cs = (*cases)[i];
+	      if (cs->exp->op == TOKstring)
+		pdt = cs->exp->toDt (pdt);
+	    }
 
-      cond_tree = build_libcall (libcall, 2, args);
+	  s->Sreadonly = true;
+	  d_finish_symbol (s);
+
+	  args[0] = d_array_value (cond_type->arrayOf()->toCtype(),
+				   size_int (cases->dim),
+				   build_address (s->Stree));
+	  args[1] = cond_tree;
+
+	  cond_tree = build_libcall (libcall, 2, args);
+	}
     }
   else if (!cond_type->isscalar())
     {
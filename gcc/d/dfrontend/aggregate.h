@@ -169,6 +169,9 @@ public:
     Type *arg2type;
 
     StructDeclaration(Loc loc, Identifier *id);
+#if MODULEINFO_IS_STRUCT
+    void setModuleInfo();
+#endif
     Dsymbol *syntaxCopy(Dsymbol *s);
     void semantic(Scope *sc);
     Dsymbol *search(Loc, Identifier *ident, int flags);
@@ -293,6 +296,7 @@ public:
                                         // and do addMember(). [== Semantic(Start,In,Done)]
 
     ClassDeclaration(Loc loc, Identifier *id, BaseClasses *baseclasses, bool inObject = false);
+    void checkSpecialName(bool inObject);
     Dsymbol *syntaxCopy(Dsymbol *s);
     void semantic(Scope *sc);
     void toCBuffer(OutBuffer *buf, HdrGenState *hgs);
@@ -25,6 +25,9 @@
 void *mem_malloc(size_t size);
 void *mem_realloc(void *p, size_t size);
 void mem_free(void *p);
+void mem_printstats(FILE *fp);
+void mem_endthread();
+void mem_pinregion();
 #else
 #include "rmem.h"
 #endif
@@ -129,7 +132,13 @@ struct Array
                 memcpy(data, &smallarray[0], dim * sizeof(*data));
             }
             else
-            {   allocdim = dim + nentries;
+            {   /* Grow geometrically, mem only extends the most recent
+                 * allocation in place, others are copied.
+                 */
+                size_t increment = dim / 2;
+                if (nentries > increment)
+                    increment = nentries;
+                allocdim = dim + increment;
 #ifdef IN_GCC
                 data = (TYPE **)mem_realloc(data, allocdim * sizeof(*data));
 #else
@@ -23,6 +23,7 @@ class LabelDsymbol;
 class Initializer;
 class Module;
 class Condition;
+class ConditionalDeclaration;
 struct HdrGenState;
 
 /**************************************************************/
@@ -58,6 +59,7 @@ public:
     void toCBuffer(OutBuffer *buf, HdrGenState *hgs);
     void toJson(JsonOut *json);
     AttribDeclaration *isAttribDeclaration() { return this; }
+    virtual ConditionalDeclaration *isConditionalDeclaration() { return NULL; }
 
     void toObjFile(int multiobj);                       // compile to .obj file
 };
@@ -176,6 +178,7 @@ public:
     void toJson(JsonOut *json);
     void importAll(Scope *sc);
     void setScope(Scope *sc);
+    ConditionalDeclaration *isConditionalDeclaration() { return this; }
 };
 
 class StaticIfDeclaration : public ConditionalDeclaration
@@ -40,8 +40,6 @@ ClassDeclaration *ClassDeclaration::errorException;
 ClassDeclaration::ClassDeclaration(Loc loc, Identifier *id, BaseClasses *baseclasses, bool inObject)
     : AggregateDeclaration(loc, id)
 {
-    static const char msg[] = "only object.d can define this reserved class name";
-
     if (baseclasses)
         // Actually, this is a transfer
         this->baseclasses = baseclasses;
@@ -67,169 +65,185 @@ ClassDeclaration::ClassDeclaration(Loc loc, Identifier *id, BaseClasses *basecla
     vclassinfo = NULL;
 
     if (id)
-    {   // Look for special class names
-
-        if (id == Id::__sizeof || id == Id::__xalignof || id == Id::mangleof)
-            error("illegal class name");
+    {   // Look for special class names, unless parsing ahead on a worker
+        // thread: then the module does it, once it is really parsed
+        if (Module::parsingAhead)
+            Module::parsingAhead->aheadClasses.push(this);
+        else
+            checkSpecialName(inObject);
+    }
 
-        // BUG: What if this is the wrong TypeInfo, i.e. it is nested?
-        if (id->toChars()[0] == 'T')
-        {
-            if (id == Id::TypeInfo)
-            {   if (!inObject)
-                    error("%s", msg);
-                Type::dtypeinfo = this;
-            }
+    com = 0;
+    cpp = 0;
+    isscope = 0;
+    isabstract = 0;
+    inuse = 0;
+    doAncestorsSemantic = SemanticStart;
+}
 
-            if (id == Id::TypeInfo_Class)
-            {   if (!inObject)
-                    error("%s", msg);
-                Type::typeinfoclass = this;
-            }
+/****************************************
+ * Set the global for a class which the compiler knows by name, and
+ * complain if it isn't declared in object.
+ */
 
-            if (id == Id::TypeInfo_Interface)
-            {   if (!inObject)
-                    error("%s", msg);
-                Type::typeinfointerface = this;
-            }
+void ClassDeclaration::checkSpecialName(bool inObject)
+{
+    static const char msg[] = "only object.d can define this reserved class name";
+    Identifier *id = ident;
 
-            if (id == Id::TypeInfo_Struct)
-            {   if (!inObject)
-                    error("%s", msg);
-                Type::typeinfostruct = this;
-            }
+    if (id == Id::__sizeof || id == Id::__xalignof || id == Id::mangleof)
+        error("illegal class name");
 
-            if (id == Id::TypeInfo_Typedef)
-            {   if (!inObject)
-                    error("%s", msg);
-                Type::typeinfotypedef = this;
-            }
+    // BUG: What if this is the wrong TypeInfo, i.e. it is nested?
+    if (id->toChars()[0] == 'T')
+    {
+        if (id == Id::TypeInfo)
+        {   if (!inObject)
+                error("%s", msg);
+            Type::dtypeinfo = this;
+        }
 
-            if (id == Id::TypeInfo_Pointer)
-            {   if (!inObject)
-                    error("%s", msg);
-                Type::typeinfopointer = this;
-            }
+        if (id == Id::TypeInfo_Class)
+        {   if (!inObject)
+                error("%s", msg);
+            Type::typeinfoclass = this;
+        }
 
-            if (id == Id::TypeInfo_Array)
-            {   if (!inObject)
-                    error("%s", msg);
-                Type::typeinfoarray = this;
-            }
+        if (id == Id::TypeInfo_Interface)
+        {   if (!inObject)
+                error("%s", msg);
+            Type::typeinfointerface = this;
+        }
 
-            if (id == Id::TypeInfo_StaticArray)
-            {   //if (!inObject)
-                    //Type::typeinfostaticarray->error("%s", msg);
-                Type::typeinfostaticarray = this;
-            }
+        if (id == Id::TypeInfo_Struct)
+        {   if (!inObject)
+                error("%s", msg);
+            Type::typeinfostruct = this;
+        }
 
-            if (id == Id::TypeInfo_AssociativeArray)
-            {   if (!inObject)
-                    error("%s", msg);
-                Type::typeinfoassociativearray = this;
-            }
+        if (id == Id::TypeInfo_Typedef)
+        {   if (!inObject)
+                error("%s", msg);
+            Type::typeinfotypedef = this;
+        }
 
-            if (id == Id::TypeInfo_Enum)
-            {   if (!inObject)
-                    error("%s", msg);
-                Type::typeinfoenum = this;
-            }
+        if (id == Id::TypeInfo_Pointer)
+        {   if (!inObject)
+                error("%s", msg);
+            Type::typeinfopointer = this;
+        }
 
-            if (id == Id::TypeInfo_Function)
-            {   if (!inObject)
-                    error("%s", msg);
-                Type::typeinfofunction = this;
-            }
+        if (id == Id::TypeInfo_Array)
+        {   if (!inObject)
+                error("%s", msg);
+            Type::typeinfoarray = this;
+        }
 
-            if (id == Id::TypeInfo_Delegate)
-            {   if (!inObject)
-                    error("%s", msg);
-                Type::typeinfodelegate = this;
-            }
+        if (id == Id::TypeInfo_StaticArray)
+        {   //if (!inObject)
+                //Type::typeinfostaticarray->error("%s", msg);
+            Type::typeinfostaticarray = this;
+        }
 
-            if (id == Id::TypeInfo_Tuple)
-            {   if (!inObject)
-                    error("%s", msg);
-                Type::typeinfotypelist = this;
-            }
+        if (id == Id::TypeInfo_AssociativeArray)
+        {   if (!inObject)
+                error("%s", msg);
+            Type::typeinfoassociativearray = this;
+        }
 
-#if DMDV2
-            if (id == Id::TypeInfo_Const)
-            {   if (!inObject)
-                    error("%s", msg);
-                Type::typeinfoconst = this;
-            }
+        if (id == Id::TypeInfo_Enum)
+        {   if (!inObject)
+                error("%s", msg);
+            Type::typeinfoenum = this;
+        }
 
-            if (id == Id::TypeInfo_Invariant)
-            {   if (!inObject)
-                    error("%s", msg);
-                Type::typeinfoinvariant = this;
-            }
+        if (id == Id::TypeInfo_Function)
+        {   if (!inObject)
+                error("%s", msg);
+            Type::typeinfofunction = this;
+        }
 
-            if (id == Id::TypeInfo_Shared)
-            {   if (!inObject)
-                    error("%s", msg);
-                Type::typeinfoshared = this;
-            }
+        if (id == Id::TypeInfo_Delegate)
+        {   if (!inObject)
+                error("%s", msg);
+            Type::typeinfodelegate = this;
+        }
 
-            if (id == Id::TypeInfo_Wild)
-            {   if (!inObject)
-                    error("%s", msg);
-                Type::typeinfowild = this;
-            }
+        if (id == Id::TypeInfo_Tuple)
+        {   if (!inObject)
+                error("%s", msg);
+            Type::typeinfotypelist = this;
+        }
 
-            if (id == Id::TypeInfo_Vector)
-            {   if (!inObject)
-                    error("%s", msg);
-                Type::typeinfovector = this;
-            }
-#endif
+#if DMDV2
+        if (id == Id::TypeInfo_Const)
+        {   if (!inObject)
+                error("%s", msg);
+            Type::typeinfoconst = this;
         }
 
-        if (id == Id::Object)
+        if (id == Id::TypeInfo_Invariant)
         {   if (!inObject)
                 error("%s", msg);
-            object = this;
+            Type::typeinfoinvariant = this;
         }
 
-        if (id == Id::Throwable)
+        if (id == Id::TypeInfo_Shared)
         {   if (!inObject)
                 error("%s", msg);
-            throwable = this;
+            Type::typeinfoshared = this;
         }
 
-        if (id == Id::Exception)
+        if (id == Id::TypeInfo_Wild)
         {   if (!inObject)
                 error("%s", msg);
-            exception = this;
+            Type::typeinfowild = this;
         }
 
-        if (id == Id::Error)
+        if (id == Id::TypeInfo_Vector)
         {   if (!inObject)
                 error("%s", msg);
-            errorException = this;
+            Type::typeinfovector = this;
         }
+#endif
+    }
+
+    if (id == Id::Object)
+    {   if (!inObject)
+            error("%s", msg);
+        object = this;
+    }
+
+    if (id == Id::Throwable)
+    {   if (!inObject)
+            error("%s", msg);
+        throwable = this;
+    }
+
+    if (id == Id::Exception)
+    {   if (!inObject)
+            error("%s", msg);
+        exception = this;
+    }
+
+    if (id == Id::Error)
+    {   if (!inObject)
+            error("%s", msg);
+        errorException = this;
+    }
 
 #if !MODULEINFO_IS_STRUCT
   #ifdef DMDV2
-        if (id == Id::ModuleInfo && !Module::moduleinfo)
-            Module::moduleinfo = this;
+    if (id == Id::ModuleInfo && !Module::moduleinfo)
+        Module::moduleinfo = this;
   #else
-        if (id == Id::ModuleInfo)
-        {   if (Module::moduleinfo)
-                error("%s", msg);
-            Module::moduleinfo = this;
-        }
+    if (id == Id::ModuleInfo)
+    {   if (Module::moduleinfo)
+            error("%s", msg);
+        Module::moduleinfo = this;
+    }
   #endif
 #endif
-    }
-
-    com = 0;
-    cpp = 0;
-    isscope = 0;
-    isabstract = 0;
-    inuse = 0;
-    doAncestorsSemantic = SemanticStart;
 }
 
 Dsymbol *ClassDeclaration::syntaxCopy(Dsymbol *s)
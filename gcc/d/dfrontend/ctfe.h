@@ -30,6 +30,143 @@ struct CtfeStatus
     static int numAssignments; // total number of assignments executed
 };
 
+// Maximum allowable recursive function calls in CTFE
+#define CTFE_RECURSION_LIMIT 1000
+
+struct AA;
+struct CtfeInstr;
+struct CtfeLoop;
+
+/**
+  The characters of a string which is appended to in CTFE, with spare
+  capacity so that each append takes amortised constant time. Several
+  StringExps may view the start of the same buffer; as in the D runtime,
+  only one which ends where the used part ends can grow in place, so
+  appending never overwrites characters visible through another.
+ */
+struct CtfeStringBuffer
+{
+    void *data;         // the characters, followed by a terminating 0
+    size_t used;        // characters in use by the longest view
+    size_t capacity;    // characters that fit, not counting the 0
+};
+
+/**
+  The same for the elements of an array literal. Each ArrayLiteralExp
+  viewing the buffer has Expressions of its own length, which borrow the
+  elements; CTFE never grows or frees the Expressions of an existing
+  literal, and scrubReturnValue gives each view its own copy once it
+  leaves CTFE.
+ */
+struct CtfeArrayBuffer
+{
+    Expression **data;  // the elements
+    size_t used;        // elements in use by the longest view
+    size_t capacity;    // elements that fit
+};
+
+/**
+  A value held by a bytecode register: an integer, normalized to its type,
+  or a real floating point number.
+ */
+union CtfeValue
+{
+    dinteger_t i;
+    real_t f;
+};
+
+/**
+  Bytecode for a function whose parameters, variables and result are all
+  integral or real floating point scalars, or static arrays of them, which
+  are only ever indexed, filled or returned whole. Values live unboxed in
+  registers: the parameters and variables first, each array taking one
+  register per element, then the temporaries. It is built by the ctfeCompile()
+  pass, and run by FuncDeclaration::interpret() before it falls back to
+  interpreting the AST. Anything the bytecode can't handle, including all
+  errors, makes it bail out, and the AST interpreter then runs the call
+  from the start. This is safe because bytecode functions have no side
+  effects outside their own frame.
+
+  Only plain functions are covered: no this or context pointer, no ref,
+  out or lazy parameters, no variadics, and every parameter a scalar.
+  A call only starts in bytecode when each of its arguments interprets
+  to an integer or real literal, and a call between bytecode functions
+  stays in bytecode only while the callee can be compiled too. Anything
+  else - strings, structs, slices, pointers, classes, closures - always
+  goes through the AST interpreter.
+ */
+struct CtfeCode
+{
+    FuncDeclaration *func;
+    CtfeInstr *code;            // the instructions
+    size_t codedim;
+    size_t codealloc;
+    CtfeValue *consts;          // constants loaded by CTFEldc
+    size_t constsdim;
+    size_t constsalloc;
+    FuncDeclarations callees;   // functions called by CTFEcall
+    int nlocals;                // registers for parameters and variables
+    int nregs;                  // all registers, including temporaries
+    bool failed;                // can't be compiled, or can never run
+    int fallbacks;              // AST reruns of bailed out calls in progress
+
+    // State used while compiling
+    AA *vars;                   // register + 1 of each VarDeclaration
+    AA *dims;                   // length of each array VarDeclaration
+    int ntemps;                 // temporaries in use
+    int maxtemps;               // most temporaries ever in use
+    CtfeLoop *loop;             // innermost enclosing loop
+
+    static CtfeCode *create(FuncDeclaration *fd);
+    static bool isScalar(Type *t);
+    static bool isScalarArray(Type *t, size_t *pdim);
+
+    // Statements
+    void expStatement(Expression *e);
+    size_t jumpIfFalse(Expression *e);
+    size_t jumpIfTrue(Expression *e);
+    size_t jump();
+    size_t here();
+    void patch(size_t jmp);
+    void patchTo(size_t jmp, size_t target);
+    void returnStatement(Expression *e);
+    void beginLoop();
+    void endLoop(size_t continueTarget);
+    void breakStatement(Identifier *ident);
+    void continueStatement(Identifier *ident);
+    void cantCompile();
+    bool finish();
+
+    // Execution
+    Expression *run(Loc loc, Expressions *arguments);
+
+private:
+    CtfeCode(FuncDeclaration *fd);
+    size_t emit(int op, int ty, int a, int b = -1, int c = -1, int x = 0);
+    int newTemp();
+    int declareVar(VarDeclaration *v);
+    int declareArray(VarDeclaration *v, size_t dim);
+    int getVar(Expression *e);
+    int getArray(Expression *e, size_t *pdim);
+    int arrayIndex(Expression *e, int *pbase, size_t *pdim);
+    bool arrayAssign(Expression *e);
+    int constant(Expression *e);
+    int convert(int r, Type *from, Type *to);
+    int condition(Expression *e);
+    void move(Type *t, int a, int b);
+    int exp(Expression *e);
+    int binExp(BinExp *e);
+    int assignExp(BinExp *e);
+    int postExp(BinExp *e);
+    int callExp(CallExp *e);
+    void declaration(DeclarationExp *e);
+};
+
+/// Return the bytecode for fd, compiling it first if need be.
+/// Return NULL if fd has no bytecode, or none yet because it is
+/// still in semantic3.
+CtfeCode *getCtfeCode(FuncDeclaration *fd);
+
 /**
   A reference to a class, or an interface. We need this when we
   point to a base class (we must record what the type is).
@@ -108,6 +245,10 @@ bool needToCopyLiteral(Expression *expr);
 /// This value will be used for in-place modification.
 Expression *copyLiteral(Expression *e);
 
+/// Deep copy a CTFE result out of the memory region it was computed in.
+/// Returns NULL if it can't be copied.
+Expression *copyOutOfRegion(Expression *e);
+
 /// Set this literal to the given type, copying it if necessary
 Expression *paintTypeOntoLiteral(Type *type, Expression *lit);
 
@@ -138,12 +279,6 @@ void assignInPlace(Expression *dest, Expression *src);
 /// If 'wantRef', all elements of ae will hold references to the same val.
 void recursiveBlockAssign(ArrayLiteralExp *ae, Expression *val, bool wantRef);
 
-/// Duplicate the elements array, then set field 'indexToChange' = newelem.
-Expressions *changeOneElement(Expressions *oldelems, size_t indexToChange, Expression *newelem);
-
-/// Create a new struct literal, which is the same as se except that se.field[offset] = elem
-Expression * modifyStructField(Type *type, StructLiteralExp *se, size_t offset, Expression *newval);
-
 /// Given an AA literal aae,  set arr[index] = newval and return the new array.
 Expression *assignAssocArrayElement(Loc loc, AssocArrayLiteralExp *aae,
     Expression *index, Expression *newval);
@@ -205,6 +340,18 @@ TypeAArray *toBuiltinAAType(Type *t);
  */
 Expression *findKeyInAA(Loc loc, AssocArrayLiteralExp *ae, Expression *e2);
 
+/// Return NULL if no key in 'keys' is equal to a later key, otherwise an
+/// array of flags marking those keys which are.
+bool *findDuplicateAAKeys(Loc loc, Expressions *keys);
+
+/// Discard the lookup index of an AA literal's keys, after keys are removed
+/// or the AA leaves CTFE.
+void discardAAIndex(Expressions *keys);
+
+/// Discard the lookup indices of all AA literals, when the memory of
+/// CTFE is released.
+void discardAAIndices();
+
 /// True if type is TypeInfo_Class
 bool isTypeInfo_Class(Type *type);
 
@@ -236,9 +383,16 @@ int ctfeIdentity(Loc loc, TOK op, Expression *e1, Expression *e2);
 /// Evaluate >,<=, etc. Resolves slices before comparing. Returns 0 or 1
 int ctfeCmp(Loc loc, TOK op, Expression *e1, Expression *e2);
 
+/// Evaluate >,<=, etc. of two reals, which may be NaN. Returns 0 or 1
+int realCmp(TOK op, real_t r1, real_t r2);
+
 /// Returns e1 ~ e2. Resolves slices before concatenation.
 Expression *ctfeCat(Type *type, Expression *e1, Expression *e2);
 
+/// Returns the new value of e1 for e1 ~= e2, growing strings and arrays
+/// in place.
+Expression *ctfeCatAssign(Type *type, Expression *e1, Expression *e2);
+
 /// Same as for constfold.Index, except that it only works for static arrays,
 /// dynamic arrays, and strings.
 Expression *ctfeIndex(Loc loc, Type *type, Expression *e1, uinteger_t indx);
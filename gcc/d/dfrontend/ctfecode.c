@@ -0,0 +1,1579 @@
+// Compiler implementation of the D programming language
+// Copyright (c) 1999-2012 by Digital Mars
+// All Rights Reserved
+// written by Walter Bright
+// http://www.digitalmars.com
+// License for redistribution is by either the Artistic License
+// in artistic.txt, or the GNU General Public License in gnu.txt.
+// See the included readme.txt for details.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <string.h>                     // mem{cpy|set}()
+
+#include "rmem.h"
+#include "aav.h"
+#include "port.h"
+
+#include "expression.h"
+#include "statement.h"
+#include "declaration.h"
+#include "init.h"
+#include "mtype.h"
+#include "ctfe.h"
+
+#define LOGCOMPILE 0
+
+/* The CTFE bytecode.
+ * Registers a, b and c hold operands and results; -1 means none.
+ * Integer results are normalized to the type ty, just as IntegerExp
+ * normalizes its value. Floating point results are not rounded to ty,
+ * just as RealExp doesn't round its value.
+ */
+enum CtfeOp
+{
+    CTFEldc,            // a = consts[x]
+    CTFEmov,            // a = b
+    CTFEfmov,           // a = b, floating point
+    CTFEadd,            // a = b + c
+    CTFEsub,            // a = b - c
+    CTFEmul,            // a = b * c
+    CTFEdiv,            // a = b / c
+    CTFEudiv,           // a = b / c, unsigned
+    CTFEmod,            // a = b % c
+    CTFEumod,           // a = b % c, unsigned
+    CTFEshl,            // a = b << c
+    CTFEshr,            // a = b >> c, b is of type ty1
+    CTFEushr,           // a = b >>> c, b is of type ty1
+    CTFEand,            // a = b & c
+    CTFEor,             // a = b | c
+    CTFExor,            // a = b ^ c
+    CTFEneg,            // a = -b
+    CTFEcom,            // a = ~b
+    CTFEnot,            // a = !b
+    CTFEeq,             // a = b == c
+    CTFEne,             // a = b != c
+    CTFElt,             // a = b < c
+    CTFEle,             // a = b <= c
+    CTFEgt,             // a = b > c
+    CTFEge,             // a = b >= c
+    CTFEult,            // a = b < c, unsigned
+    CTFEule,            // a = b <= c, unsigned
+    CTFEugt,            // a = b > c, unsigned
+    CTFEuge,            // a = b >= c, unsigned
+    CTFEitof,           // a = b, converted to floating point from type ty1
+    CTFEftoi,           // a = b, converted from floating point to type ty
+    CTFEfadd,           // a = b + c, floating point
+    CTFEfsub,           // a = b - c, floating point
+    CTFEfmul,           // a = b * c, floating point
+    CTFEfdiv,           // a = b / c, floating point
+    CTFEfmod,           // a = b % c, floating point
+    CTFEfneg,           // a = -b, floating point
+    CTFEfeq,            // a = b == c, floating point
+    CTFEfne,            // a = b != c, floating point
+    CTFEflt,            // a = b < c, floating point
+    CTFEfle,            // a = b <= c, floating point
+    CTFEfgt,            // a = b > c, floating point
+    CTFEfge,            // a = b >= c, floating point
+    CTFEjmp,            // goto x
+    CTFEjz,             // if (!a) goto x
+    CTFEjnz,            // if (a) goto x
+    CTFEldx,            // a = b[c], b is an array of length x
+    CTFEstx,            // a[c] = b, a is an array of length x
+    CTFEfill,           // a[0 .. x] = b
+    CTFEcall,           // a = callees[x](b, b + 1, ...)
+    CTFEret,            // return a
+    CTFEretx,           // return a[0 .. x]
+    CTFEbail,           // let the AST interpreter run the call
+};
+
+struct CtfeInstr
+{
+    unsigned char op;           // CtfeOp
+    unsigned char ty;           // TY of the result
+    unsigned char ty1;          // TY of the left operand of a shift
+    int a, b, c;                // registers
+    int x;                      // jump target, constant or callee
+};
+
+/* A loop being compiled, and the jumps out of it still to be patched.
+ */
+struct CtfeLoop
+{
+    CtfeLoop *outer;
+    Array<void> breaks;
+    Array<void> continues;
+};
+
+/* While compiling, temporary register t is encoded as -2 - t, as the
+ * number of variables isn't known until the end.
+ */
+#define TEMP(t)         (-2 - (t))
+#define ISTEMP(r)       ((r) < -1)
+
+// Longest local array held in registers
+#define MAXARRAYDIM     4096
+
+static dinteger_t normalize(unsigned ty, dinteger_t v)
+{
+    switch (ty)
+    {
+        case Tbool:     return v != 0;
+        case Tint8:     return (d_int8)v;
+        case Tchar:
+        case Tuns8:     return (d_uns8)v;
+        case Tint16:    return (d_int16)v;
+        case Twchar:
+        case Tuns16:    return (d_uns16)v;
+        case Tint32:    return (d_int32)v;
+        case Tdchar:
+        case Tuns32:    return (d_uns32)v;
+        default:        return v;
+    }
+}
+
+static unsigned tysize(unsigned ty)
+{
+    switch (ty)
+    {
+        case Tbool:
+        case Tint8:
+        case Tuns8:
+        case Tchar:     return 1;
+        case Tint16:
+        case Tuns16:
+        case Twchar:    return 2;
+        case Tint32:
+        case Tuns32:
+        case Tdchar:    return 4;
+        default:        return 8;
+    }
+}
+
+static bool tyreal(unsigned ty)
+{
+    return ty == Tfloat32 || ty == Tfloat64 || ty == Tfloat80;
+}
+
+/* Convert r to the integral type ty, as Cast() does.
+ */
+static dinteger_t realToInteger(unsigned ty, real_t r)
+{
+    switch (ty)
+    {
+        case Tint8:     return (d_int8)r;
+        case Tchar:
+        case Tuns8:     return (d_uns8)r;
+        case Tint16:    return (d_int16)r;
+        case Twchar:
+        case Tuns16:    return (d_uns16)r;
+        case Tint32:    return (d_int32)r;
+        case Tdchar:
+        case Tuns32:    return (d_uns32)r;
+        case Tint64:    return (d_int64)r;
+        case Tuns64:    return (d_uns64)r;
+        default:
+            assert(0);
+            return 0;
+    }
+}
+
+static unsigned char tyof(Type *t)
+{
+    return t->toBasetype()->ty;
+}
+
+/* Return the bytecode operator for e1 op e2, or -1 if there is none.
+ */
+static int binOp(TOK op, bool isunsigned, bool isfloat)
+{
+    if (isfloat)
+    {
+        switch (op)
+        {
+            case TOKadd:        return CTFEfadd;
+            case TOKmin:        return CTFEfsub;
+            case TOKmul:        return CTFEfmul;
+            case TOKdiv:        return CTFEfdiv;
+            case TOKmod:        return CTFEfmod;
+            case TOKequal:      return CTFEfeq;
+            case TOKnotequal:   return CTFEfne;
+            case TOKlt:         return CTFEflt;
+            case TOKle:         return CTFEfle;
+            case TOKgt:         return CTFEfgt;
+            case TOKge:         return CTFEfge;
+            default:            return -1;
+        }
+    }
+    switch (op)
+    {
+        case TOKadd:            return CTFEadd;
+        case TOKmin:            return CTFEsub;
+        case TOKmul:            return CTFEmul;
+        case TOKdiv:            return isunsigned ? CTFEudiv : CTFEdiv;
+        case TOKmod:            return isunsigned ? CTFEumod : CTFEmod;
+        case TOKshl:            return CTFEshl;
+        case TOKshr:            return CTFEshr;
+        case TOKushr:           return CTFEushr;
+        case TOKand:            return CTFEand;
+        case TOKor:             return CTFEor;
+        case TOKxor:            return CTFExor;
+        case TOKequal:
+        case TOKidentity:       return CTFEeq;
+        case TOKnotequal:
+        case TOKnotidentity:    return CTFEne;
+        case TOKlt:             return isunsigned ? CTFEult : CTFElt;
+        case TOKle:             return isunsigned ? CTFEule : CTFEle;
+        case TOKgt:             return isunsigned ? CTFEugt : CTFEgt;
+        case TOKge:             return isunsigned ? CTFEuge : CTFEge;
+        default:                return -1;
+    }
+}
+
+/* The binary operator of an op= assignment.
+ */
+static TOK assignOp(TOK op)
+{
+    switch (op)
+    {
+        case TOKaddass:         return TOKadd;
+        case TOKminass:         return TOKmin;
+        case TOKmulass:         return TOKmul;
+        case TOKdivass:         return TOKdiv;
+        case TOKmodass:         return TOKmod;
+        case TOKandass:         return TOKand;
+        case TOKorass:          return TOKor;
+        case TOKxorass:         return TOKxor;
+        case TOKshlass:         return TOKshl;
+        case TOKshrass:         return TOKshr;
+        case TOKushrass:        return TOKushr;
+        default:
+            assert(0);
+            return TOKreserved;
+    }
+}
+
+/********************************* Compiling *********************************/
+
+CtfeCode::CtfeCode(FuncDeclaration *fd)
+{
+    func = fd;
+    code = NULL;
+    codedim = 0;
+    codealloc = 0;
+    consts = NULL;
+    constsdim = 0;
+    constsalloc = 0;
+    nlocals = 0;
+    nregs = 0;
+    failed = false;
+    fallbacks = 0;
+    vars = NULL;
+    dims = NULL;
+    ntemps = 0;
+    maxtemps = 0;
+    loop = NULL;
+}
+
+/*************************************
+ * Start compiling fd. If its signature can't be handled, the result
+ * has failed set, and the rest of the compilation does nothing.
+ */
+CtfeCode *CtfeCode::create(FuncDeclaration *fd)
+{
+    CtfeCode *bc = new CtfeCode(fd);
+    TypeFunction *tf = (TypeFunction *)fd->type->toBasetype();
+    assert(tf->ty == Tfunction);
+
+    size_t dim;
+    if (fd->needThis() || fd->isNested() || fd->vresult ||
+        tf->varargs || tf->isref ||
+        (tf->next->toBasetype()->ty != Tvoid && !isScalar(tf->next) &&
+         !isScalarArray(tf->next, &dim)))
+    {
+        bc->cantCompile();
+        return bc;
+    }
+    size_t nparams = Parameter::dim(tf->parameters);
+    if (nparams != (fd->parameters ? fd->parameters->dim : 0))
+    {
+        bc->cantCompile();
+        return bc;
+    }
+    for (size_t i = 0; i < nparams; i++)
+    {
+        Parameter *arg = Parameter::getNth(tf->parameters, i);
+        if (arg->storageClass & (STCout | STCref | STClazy) || !isScalar(arg->type))
+        {
+            bc->cantCompile();
+            return bc;
+        }
+        bc->declareVar((*fd->parameters)[i]);
+    }
+    return bc;
+}
+
+/*************************************
+ * Return true if values of type t can be held in a register.
+ */
+bool CtfeCode::isScalar(Type *t)
+{
+    switch (t->toBasetype()->ty)
+    {
+        case Tbool:
+        case Tint8:  case Tuns8:
+        case Tint16: case Tuns16:
+        case Tint32: case Tuns32:
+        case Tint64: case Tuns64:
+        case Tchar:  case Twchar: case Tdchar:
+        case Tfloat32: case Tfloat64: case Tfloat80:
+            return true;
+
+        default:
+            return false;
+    }
+}
+
+/*************************************
+ * Return true if t is a static array which can be held in registers,
+ * one for each element, and set *pdim to its length. Arrays of
+ * characters are left out, as the AST interpreter makes strings of them.
+ */
+bool CtfeCode::isScalarArray(Type *t, size_t *pdim)
+{
+    Type *tb = t->toBasetype();
+    if (tb->ty != Tsarray)
+        return false;
+    Type *telem = tb->nextOf()->toBasetype();
+    if (!isScalar(telem) || telem->ty == Tchar || telem->ty == Twchar || telem->ty == Tdchar)
+        return false;
+    dinteger_t dim = ((TypeSArray *)tb)->dim->toInteger();
+    if (dim == 0 || dim > MAXARRAYDIM)
+        return false;
+    *pdim = (size_t)dim;
+    return true;
+}
+
+void CtfeCode::cantCompile()
+{
+#if LOGCOMPILE
+    printf("%s cannot compile %s to bytecode\n", func->loc.toChars(), func->toChars());
+#endif
+    failed = true;
+}
+
+size_t CtfeCode::emit(int op, int ty, int a, int b, int c, int x)
+{
+    if (codedim == codealloc)
+    {
+        codealloc = codealloc ? codealloc * 2 : 64;
+        code = (CtfeInstr *)mem.realloc(code, codealloc * sizeof(CtfeInstr));
+    }
+    CtfeInstr *ci = &code[codedim];
+    ci->op = op;
+    ci->ty = ty;
+    ci->ty1 = 0;
+    ci->a = a;
+    ci->b = b;
+    ci->c = c;
+    ci->x = x;
+    return codedim++;
+}
+
+int CtfeCode::newTemp()
+{
+    int t = ntemps++;
+    if (ntemps > maxtemps)
+        maxtemps = ntemps;
+    return TEMP(t);
+}
+
+int CtfeCode::declareVar(VarDeclaration *v)
+{
+    Value *pv = _aaGet(&vars, v);
+    if (!*pv)
+        *pv = (Value)(size_t)(++nlocals);
+    return (int)(size_t)*pv - 1;
+}
+
+/*************************************
+ * Give the local array v dim consecutive registers, and return the first.
+ */
+int CtfeCode::declareArray(VarDeclaration *v, size_t dim)
+{
+    Value *pv = _aaGet(&vars, v);
+    if (!*pv)
+    {
+        *pv = (Value)(size_t)(nlocals + 1);
+        *_aaGet(&dims, v) = (Value)dim;
+        nlocals += dim;
+    }
+    return (int)(size_t)*pv - 1;
+}
+
+/*************************************
+ * Return the register of the local variable e refers to, or -1.
+ */
+int CtfeCode::getVar(Expression *e)
+{
+    if (e->op != TOKvar)
+        return -1;
+    VarDeclaration *v = ((VarExp *)e)->var->isVarDeclaration();
+    if (!v || _aaGetRvalue(dims, v))
+        return -1;
+    Value pv = _aaGetRvalue(vars, v);
+    return pv ? (int)(size_t)pv - 1 : -1;
+}
+
+/*************************************
+ * Return the first register of the local array e refers to, and set
+ * *pdim to its length, or return -1.
+ */
+int CtfeCode::getArray(Expression *e, size_t *pdim)
+{
+    if (e->op != TOKvar)
+        return -1;
+    VarDeclaration *v = ((VarExp *)e)->var->isVarDeclaration();
+    if (!v)
+        return -1;
+    Value dim = _aaGetRvalue(dims, v);
+    if (!dim)
+        return -1;
+    *pdim = (size_t)dim;
+    return (int)(size_t)_aaGetRvalue(vars, v) - 1;
+}
+
+/*************************************
+ * If e is an element of a local array, compile its index, set *pbase and
+ * *pdim to the array's first register and length, and return the
+ * register holding the index. Otherwise return -1.
+ */
+int CtfeCode::arrayIndex(Expression *e, int *pbase, size_t *pdim)
+{
+    if (e->op != TOKindex)
+        return -1;
+    IndexExp *ie = (IndexExp *)e;
+    if (ie->lengthVar || !isScalar(ie->e2->type) || tyreal(tyof(ie->e2->type)))
+        return -1;
+    int base = getArray(ie->e1, pdim);
+    if (base < 0)
+        return -1;
+    *pbase = base;
+    return exp(ie->e2);
+}
+
+/*************************************
+ * Compile an assignment to all of a local array, which fills it with a
+ * scalar or copies an array literal into it. Return false if e isn't
+ * an assignment to a local array.
+ */
+bool CtfeCode::arrayAssign(Expression *e)
+{
+    if (e->op != TOKassign && e->op != TOKconstruct && e->op != TOKblit)
+        return false;
+    BinExp *be = (BinExp *)e;
+    Expression *e1 = be->e1;
+    if (e1->op == TOKslice)
+    {
+        SliceExp *se = (SliceExp *)e1;
+        if (se->lwr || se->upr)
+            return false;
+        e1 = se->e1;
+    }
+    size_t dim;
+    int base = getArray(e1, &dim);
+    if (base < 0)
+        return false;
+
+    Type *telem = e1->type->toBasetype()->nextOf();
+    unsigned char ty = tyof(telem);
+    Expression *e2 = be->e2;
+    if (e2->op == TOKarrayliteral && e->op != TOKassign)
+    {   // Only when constructing, as the elements can't read the array then
+        Expressions *elements = ((ArrayLiteralExp *)e2)->elements;
+        if (!elements || elements->dim != dim)
+        {
+            cantCompile();
+            return true;
+        }
+        int oldtemps = ntemps;
+        for (size_t i = 0; i < dim; i++)
+        {
+            Expression *el = (*elements)[i];
+            if (!isScalar(el->type) || tyreal(tyof(el->type)) != tyreal(ty))
+            {
+                cantCompile();
+                return true;
+            }
+            move(telem, base + (int)i, exp(el));
+            ntemps = oldtemps;
+        }
+    }
+    else if (isScalar(e2->type) && tyreal(tyof(e2->type)) == tyreal(ty))
+        emit(CTFEfill, ty, base, exp(e2), -1, dim);
+    else
+        cantCompile();
+    return true;
+}
+
+int CtfeCode::constant(Expression *e)
+{
+    if (constsdim == constsalloc)
+    {
+        constsalloc = constsalloc ? constsalloc * 2 : 16;
+        consts = (CtfeValue *)mem.realloc(consts, constsalloc * sizeof(CtfeValue));
+    }
+    unsigned char ty = tyof(e->type);
+    if (tyreal(ty))
+        consts[constsdim].f = e->toReal();
+    else
+        consts[constsdim].i = normalize(ty, e->toInteger());
+    int r = newTemp();
+    emit(CTFEldc, ty, r, -1, -1, constsdim++);
+    return r;
+}
+
+/*************************************
+ * Convert the value in register r from type from to type to,
+ * and return the register holding the result.
+ */
+int CtfeCode::convert(int r, Type *from, Type *to)
+{
+    unsigned char fromty = tyof(from);
+    unsigned char toty = tyof(to);
+    int op;
+    if (!tyreal(fromty))
+        op = tyreal(toty) ? CTFEitof : CTFEmov;
+    else if (tyreal(toty))
+        op = CTFEfmov;
+    else if (toty != Tbool)
+        op = CTFEftoi;
+    else
+    {   // Cast() makes a bool of the truncated value
+        cantCompile();
+        return -1;
+    }
+    int t = newTemp();
+    size_t i = emit(op, toty, t, r);
+    code[i].ty1 = fromty;
+    return t;
+}
+
+/*************************************
+ * Compile a condition, and return the register holding its value.
+ */
+int CtfeCode::condition(Expression *e)
+{
+    if (!isScalar(e->type) || tyreal(tyof(e->type)))
+    {
+        cantCompile();
+        return -1;
+    }
+    return exp(e);
+}
+
+/*************************************
+ * Compile expression e. Return the register holding its value,
+ * or -1 if it has none.
+ */
+int CtfeCode::exp(Expression *e)
+{
+    if (failed)
+        return -1;
+    if (!e->type)
+    {
+        cantCompile();
+        return -1;
+    }
+
+    Type *tb = e->type->toBasetype();
+    if (tb->ty != Tvoid && !isScalar(tb))
+    {
+        cantCompile();
+        return -1;
+    }
+
+    switch (e->op)
+    {
+        case TOKint64:
+        case TOKfloat64:
+            return constant(e);
+
+        case TOKvar:
+        {
+            int r = getVar(e);
+            if (r < 0)
+                cantCompile();
+            return r;
+        }
+
+        case TOKdeclaration:
+            declaration((DeclarationExp *)e);
+            return -1;
+
+        case TOKcomma:
+        {
+            CommaExp *ce = (CommaExp *)e;
+            if (!arrayAssign(ce->e1))
+                exp(ce->e1);
+            return exp(ce->e2);
+        }
+
+        case TOKindex:
+        {
+            int base;
+            size_t dim;
+            int ri = arrayIndex(e, &base, &dim);
+            if (ri == -1)
+                break;
+            int r = newTemp();
+            emit(CTFEldx, tyof(e->type), r, base, ri, dim);
+            return r;
+        }
+
+        case TOKassign:
+        case TOKconstruct:
+        case TOKblit:
+            return assignExp((BinExp *)e);
+
+        case TOKaddass:
+        case TOKminass:
+        case TOKmulass:
+        case TOKdivass:
+        case TOKmodass:
+        case TOKandass:
+        case TOKorass:
+        case TOKxorass:
+        case TOKshlass:
+        case TOKshrass:
+        case TOKushrass:
+            return assignExp((BinExp *)e);
+
+        case TOKplusplus:
+        case TOKminusminus:
+            return postExp((BinExp *)e);
+
+        case TOKadd:
+        case TOKmin:
+        case TOKmul:
+        case TOKdiv:
+        case TOKmod:
+        case TOKshl:
+        case TOKshr:
+        case TOKushr:
+        case TOKand:
+        case TOKor:
+        case TOKxor:
+        case TOKequal:
+        case TOKnotequal:
+        case TOKidentity:
+        case TOKnotidentity:
+        case TOKlt:
+        case TOKle:
+        case TOKgt:
+        case TOKge:
+            return binExp((BinExp *)e);
+
+        case TOKneg:
+        case TOKtilde:
+        case TOKnot:
+        {
+            UnaExp *ue = (UnaExp *)e;
+            if (!isScalar(ue->e1->type))
+                break;
+            int op;
+            int r1;
+            if (e->op == TOKnot)
+            {
+                op = CTFEnot;
+                r1 = condition(ue->e1);
+            }
+            else if (tyreal(tyof(ue->e1->type)))
+            {
+                if (e->op != TOKneg)
+                    break;
+                op = CTFEfneg;
+                r1 = exp(ue->e1);
+            }
+            else
+            {
+                op = e->op == TOKneg ? CTFEneg : CTFEcom;
+                r1 = exp(ue->e1);
+            }
+            int r = newTemp();
+            emit(op, tyof(e->type), r, r1);
+            return r;
+        }
+
+        case TOKcast:
+        {
+            CastExp *ce = (CastExp *)e;
+            if (tb->ty == Tvoid)
+            {
+                exp(ce->e1);
+                return -1;
+            }
+            if (!isScalar(ce->e1->type))
+                break;
+            return convert(exp(ce->e1), ce->e1->type, e->type);
+        }
+
+        case TOKandand:
+        case TOKoror:
+        {
+            BinExp *be = (BinExp *)e;
+            if (tb->ty != Tbool)
+                break;
+            int r = newTemp();
+            emit(CTFEmov, Tbool, r, condition(be->e1));
+            size_t j = emit(e->op == TOKandand ? CTFEjz : CTFEjnz, 0, r);
+            emit(CTFEmov, Tbool, r, condition(be->e2));
+            patch(j);
+            return r;
+        }
+
+        case TOKquestion:
+        {
+            CondExp *ce = (CondExp *)e;
+            int r = tb->ty == Tvoid ? -1 : newTemp();
+            size_t jelse = emit(CTFEjz, 0, condition(ce->econd));
+            int r1 = exp(ce->e1);
+            if (r != -1)
+                move(e->type, r, r1);
+            size_t jend = jump();
+            patch(jelse);
+            int r2 = exp(ce->e2);
+            if (r != -1)
+                move(e->type, r, r2);
+            patch(jend);
+            return r;
+        }
+
+        case TOKcall:
+            return callExp((CallExp *)e);
+
+        case TOKassert:
+        {
+            // A failed assert bails out, so that the AST interpreter
+            // reports it.
+            AssertExp *ae = (AssertExp *)e;
+            size_t j = emit(CTFEjnz, 0, condition(ae->e1));
+            emit(CTFEbail, 0, -1);
+            patch(j);
+            return -1;
+        }
+
+        case TOKhalt:
+            emit(CTFEbail, 0, -1);
+            return -1;
+
+        default:
+            break;
+    }
+    cantCompile();
+    return -1;
+}
+
+int CtfeCode::binExp(BinExp *e)
+{
+    if (!isScalar(e->e1->type) || !isScalar(e->e2->type))
+    {
+        cantCompile();
+        return -1;
+    }
+    bool isunsigned = e->e1->type->isunsigned() || e->e2->type->isunsigned();
+    bool isfloat = tyreal(tyof(e->e1->type));
+    int op = binOp(e->op, isunsigned, isfloat);
+    if (op == -1 || tyreal(tyof(e->e2->type)) != isfloat)
+    {
+        cantCompile();
+        return -1;
+    }
+
+    int r1 = exp(e->e1);
+    if (!ISTEMP(r1) && e->e2->hasSideEffect())
+    {   // e2 may change the variable, so take its value now
+        int t = newTemp();
+        move(e->e1->type, t, r1);
+        r1 = t;
+    }
+    int r2 = exp(e->e2);
+    int r = newTemp();
+    size_t i = emit(op, tyof(e->type), r, r1, r2);
+    code[i].ty1 = tyof(e->e1->type);
+    return r;
+}
+
+/*************************************
+ * Compile v = e2, and v op= e2, where v is a local variable
+ * or an element of a local array.
+ */
+int CtfeCode::assignExp(BinExp *e)
+{
+    // Like interpretAssignCommon(), look through casts of the
+    // variable in read-modify-write assignments.
+    Expression *e1 = e->e1;
+    if (e->op != TOKassign && e->op != TOKconstruct && e->op != TOKblit)
+    {
+        while (e1->op == TOKcast)
+            e1 = ((CastExp *)e1)->e1;
+    }
+    if (!isScalar(e1->type) || !isScalar(e->e2->type))
+    {
+        cantCompile();
+        return -1;
+    }
+    unsigned char vty = tyof(e1->type);
+    bool isfloat = tyreal(vty);
+    if (tyreal(tyof(e->e2->type)) != isfloat)
+    {
+        cantCompile();
+        return -1;
+    }
+
+    // An array element is loaded into rv, and stored back at the end
+    int base;
+    size_t dim;
+    int ri = -1;
+    int rv;
+    if (e1->op == TOKindex)
+    {
+        ri = arrayIndex(e1, &base, &dim);
+        if (ri == -1)
+        {
+            cantCompile();
+            return -1;
+        }
+        if (!ISTEMP(ri) && e->e2->hasSideEffect())
+        {   // e2 may change the index, so take its value now
+            int t = newTemp();
+            emit(CTFEmov, tyof(((IndexExp *)e1)->e2->type), t, ri);
+            ri = t;
+        }
+        rv = newTemp();
+    }
+    else if ((rv = getVar(e1)) < 0)
+    {
+        cantCompile();
+        return -1;
+    }
+
+    int r2 = exp(e->e2);
+    if (e->op == TOKassign || e->op == TOKconstruct || e->op == TOKblit)
+    {
+        move(e1->type, rv, r2);
+        if (ri != -1)
+            emit(CTFEstx, vty, base, rv, ri, dim);
+        return rv;
+    }
+    if (ri != -1)
+        emit(CTFEldx, vty, rv, base, ri, dim);
+
+    bool isunsigned = e1->type->isunsigned() || e->e2->type->isunsigned();
+    int op = binOp(assignOp(e->op), isunsigned, isfloat);
+    if (op == -1 || tyreal(tyof(e->type)) != isfloat)
+    {
+        cantCompile();
+        return -1;
+    }
+    int r = newTemp();
+    size_t i = emit(op, tyof(e->type), r, rv, r2);
+    code[i].ty1 = vty;
+    move(e1->type, rv, r);
+    if (ri != -1)
+        emit(CTFEstx, vty, base, rv, ri, dim);
+    return rv;
+}
+
+/*************************************
+ * Compile v++ and v--, where v is a local variable
+ * or an element of a local array.
+ */
+int CtfeCode::postExp(BinExp *e)
+{
+    Expression *e1 = e->e1;
+    while (e1->op == TOKcast)
+        e1 = ((CastExp *)e1)->e1;
+    if (!isScalar(e1->type) || !isScalar(e->e2->type))
+    {
+        cantCompile();
+        return -1;
+    }
+    bool isfloat = tyreal(tyof(e1->type));
+    if (tyreal(tyof(e->e2->type)) != isfloat || tyreal(tyof(e->type)) != isfloat)
+    {
+        cantCompile();
+        return -1;
+    }
+
+    int base;
+    size_t dim;
+    int ri = -1;
+    int rv;
+    if (e1->op == TOKindex)
+    {
+        ri = arrayIndex(e1, &base, &dim);
+        if (ri == -1)
+        {
+            cantCompile();
+            return -1;
+        }
+        rv = newTemp();
+        emit(CTFEldx, tyof(e1->type), rv, base, ri, dim);
+    }
+    else if ((rv = getVar(e1)) < 0)
+    {
+        cantCompile();
+        return -1;
+    }
+
+    int r2 = exp(e->e2);
+    int old = newTemp();
+    move(e->type, old, rv);
+    int r = newTemp();
+    int op = binOp(e->op == TOKplusplus ? TOKadd : TOKmin, false, isfloat);
+    emit(op, tyof(e->type), r, rv, r2);
+    move(e1->type, rv, r);
+    if (ri != -1)
+        emit(CTFEstx, tyof(e1->type), base, rv, ri, dim);
+    return old;
+}
+
+/*************************************
+ * Copy register b to register a, which holds a value of type t.
+ */
+void CtfeCode::move(Type *t, int a, int b)
+{
+    unsigned char ty = tyof(t);
+    emit(tyreal(ty) ? CTFEfmov : CTFEmov, ty, a, b);
+}
+
+/*************************************
+ * Compile a direct call. The arguments are put in consecutive
+ * temporaries, which become the parameters of the callee's frame.
+ */
+int CtfeCode::callExp(CallExp *e)
+{
+    FuncDeclaration *fd = NULL;
+    if (e->e1->op == TOKvar)
+        fd = ((VarExp *)e->e1)->var->isFuncDeclaration();
+    if (!fd || fd->needThis() || fd->isNested())
+    {
+        cantCompile();
+        return -1;
+    }
+    TypeFunction *tf = (TypeFunction *)fd->type->toBasetype();
+    assert(tf->ty == Tfunction);
+    size_t nargs = e->arguments ? e->arguments->dim : 0;
+    if (tf->varargs || tf->isref || Parameter::dim(tf->parameters) != nargs)
+    {
+        cantCompile();
+        return -1;
+    }
+
+    // Temporaries allocated in a row get consecutive registers
+    int args = -1;
+    for (size_t i = 0; i < nargs; i++)
+    {
+        Parameter *arg = Parameter::getNth(tf->parameters, i);
+        if (arg->storageClass & (STCout | STCref | STClazy) || !isScalar(arg->type))
+        {
+            cantCompile();
+            return -1;
+        }
+        int t = newTemp();
+        if (i == 0)
+            args = t;
+    }
+    for (size_t i = 0; i < nargs; i++)
+    {
+        Parameter *arg = Parameter::getNth(tf->parameters, i);
+        move(arg->type, args - (int)i, exp((*e->arguments)[i]));
+    }
+
+    size_t x;
+    for (x = 0; x < callees.dim; x++)
+    {
+        if (callees[x] == fd)
+            break;
+    }
+    if (x == callees.dim)
+        callees.push(fd);
+
+    int r = tf->next->toBasetype()->ty == Tvoid ? -1 : newTemp();
+    emit(CTFEcall, r == -1 ? Tvoid : tyof(tf->next), r, args, -1, x);
+    return r;
+}
+
+void CtfeCode::declaration(DeclarationExp *e)
+{
+    VarDeclaration *v = e->declaration->isVarDeclaration();
+    if (!v || v->toAlias() != v)
+    {
+        cantCompile();
+        return;
+    }
+    if (v->storage_class & STCmanifest)
+        return;
+    size_t dim = 0;
+    if (v->isDataseg() || v->storage_class & (STCout | STCref | STClazy) ||
+        !(isScalar(v->type) || isScalarArray(v->type, &dim)) || !v->init)
+    {
+        cantCompile();
+        return;
+    }
+    ExpInitializer *ie = v->init->isExpInitializer();
+    if (!ie)
+    {   // void initializers leave the value undefined, which the
+        // AST interpreter diagnoses
+        cantCompile();
+        return;
+    }
+    if (dim)
+    {
+        declareArray(v, dim);
+        if (!arrayAssign(ie->exp))
+            cantCompile();
+        return;
+    }
+    declareVar(v);
+    exp(ie->exp);
+}
+
+/*************************************
+ * Compile an expression evaluated as a statement.
+ * No temporaries are live between statements.
+ */
+void CtfeCode::expStatement(Expression *e)
+{
+    ntemps = 0;
+    if (!arrayAssign(e))
+        exp(e);
+}
+
+size_t CtfeCode::jumpIfFalse(Expression *e)
+{
+    ntemps = 0;
+    return emit(CTFEjz, 0, condition(e));
+}
+
+size_t CtfeCode::jumpIfTrue(Expression *e)
+{
+    ntemps = 0;
+    return emit(CTFEjnz, 0, condition(e));
+}
+
+size_t CtfeCode::jump()
+{
+    return emit(CTFEjmp, 0, -1);
+}
+
+size_t CtfeCode::here()
+{
+    return codedim;
+}
+
+void CtfeCode::patch(size_t jmp)
+{
+    patchTo(jmp, codedim);
+}
+
+void CtfeCode::patchTo(size_t jmp, size_t target)
+{
+    if (jmp < codedim)
+        code[jmp].x = target;
+}
+
+void CtfeCode::returnStatement(Expression *e)
+{
+    ntemps = 0;
+    Type *tret = func->type->nextOf();
+    size_t dim;
+    if (tret->toBasetype()->ty == Tvoid)
+    {
+        if (e)
+            exp(e);
+        emit(CTFEret, Tvoid, -1);
+    }
+    else if (isScalarArray(tret, &dim))
+    {
+        size_t edim;
+        int base = getArray(e, &edim);
+        if (base < 0 || edim != dim)
+        {
+            cantCompile();
+            return;
+        }
+        emit(CTFEretx, tyof(tret->nextOf()), base, -1, -1, dim);
+    }
+    else
+    {
+        assert(e);
+        emit(CTFEret, tyof(tret), exp(e));
+    }
+}
+
+void CtfeCode::beginLoop()
+{
+    CtfeLoop *l = new CtfeLoop();
+    l->outer = loop;
+    loop = l;
+}
+
+void CtfeCode::endLoop(size_t continueTarget)
+{
+    CtfeLoop *l = loop;
+    for (size_t i = 0; i < l->breaks.dim; i++)
+        patch((size_t)l->breaks[i]);
+    for (size_t i = 0; i < l->continues.dim; i++)
+        patchTo((size_t)l->continues[i], continueTarget);
+    loop = l->outer;
+    delete l;
+}
+
+void CtfeCode::breakStatement(Identifier *ident)
+{
+    if (ident || !loop)
+    {   // labelled, or out of a switch
+        cantCompile();
+        return;
+    }
+    loop->breaks.push((void *)jump());
+}
+
+void CtfeCode::continueStatement(Identifier *ident)
+{
+    if (ident || !loop)
+    {
+        cantCompile();
+        return;
+    }
+    loop->continues.push((void *)jump());
+}
+
+/*************************************
+ * Finish compiling: fall off the end of the function, and give the
+ * temporaries their registers. Return false if it can't be compiled.
+ */
+bool CtfeCode::finish()
+{
+    if (failed)
+        return false;
+
+    // Falling off the end of a non-void function is an error
+    if (func->type->nextOf()->toBasetype()->ty == Tvoid)
+        emit(CTFEret, Tvoid, -1);
+    else
+        emit(CTFEbail, 0, -1);
+
+    for (size_t i = 0; i < codedim; i++)
+    {
+        CtfeInstr *ci = &code[i];
+        if (ISTEMP(ci->a))
+            ci->a = nlocals - 2 - ci->a;
+        if (ISTEMP(ci->b))
+            ci->b = nlocals - 2 - ci->b;
+        if (ISTEMP(ci->c))
+            ci->c = nlocals - 2 - ci->c;
+    }
+    nregs = nlocals + maxtemps;
+    vars = NULL;
+    dims = NULL;
+#if LOGCOMPILE
+    printf("%s compiled %s to %d instructions, %d registers\n",
+        func->loc.toChars(), func->toChars(), (int)codedim, nregs);
+#endif
+    return true;
+}
+
+/********************************* Execution *********************************/
+
+/* The registers of all the active frames. Compiling a callee can start
+ * another evaluation, so the frames of a new run go after all of these.
+ */
+static CtfeValue *ctfeRegs;
+static size_t ctfeRegsDim;
+static size_t ctfeRegsUsed;
+
+static void reserveRegs(size_t dim)
+{
+    if (dim > ctfeRegsDim)
+    {
+        ctfeRegsDim = dim < 1024 ? 1024 : dim * 2;
+        ctfeRegs = (CtfeValue *)mem.realloc(ctfeRegs, ctfeRegsDim * sizeof(CtfeValue));
+        mem.pinRegion();        // they must outlive the CTFE region
+    }
+}
+
+/*************************************
+ * Run bc in the frame starting at register base.
+ * Return false to bail out.
+ */
+static bool execute(CtfeCode *bc, size_t base, CtfeValue *presult)
+{
+    if (++CtfeStatus::callDepth > CTFE_RECURSION_LIMIT)
+    {
+        --CtfeStatus::callDepth;
+        return false;
+    }
+    if (CtfeStatus::callDepth > CtfeStatus::maxCallDepth)
+        CtfeStatus::maxCallDepth = CtfeStatus::callDepth;
+    size_t oldUsed = ctfeRegsUsed;
+    ctfeRegsUsed = base + bc->nregs;
+
+    CtfeInstr *code = bc->code;
+    CtfeValue *r = ctfeRegs + base;
+    size_t pc = 0;
+    while (1)
+    {
+        CtfeInstr *ci = &code[pc++];
+        switch (ci->op)
+        {
+            case CTFEldc:
+                r[ci->a] = bc->consts[ci->x];
+                break;
+
+            case CTFEmov:
+                r[ci->a].i = normalize(ci->ty, r[ci->b].i);
+                break;
+
+            case CTFEfmov:
+                r[ci->a].f = r[ci->b].f;
+                break;
+
+            case CTFEadd:
+                r[ci->a].i = normalize(ci->ty, r[ci->b].i + r[ci->c].i);
+                break;
+
+            case CTFEsub:
+                r[ci->a].i = normalize(ci->ty, r[ci->b].i - r[ci->c].i);
+                break;
+
+            case CTFEmul:
+                r[ci->a].i = normalize(ci->ty, r[ci->b].i * r[ci->c].i);
+                break;
+
+            case CTFEdiv:
+            {
+                sinteger_t n1 = r[ci->b].i;
+                sinteger_t n2 = r[ci->c].i;
+                if (n2 == 0 || (n2 == -1 && n1 == (sinteger_t)0x8000000000000000LL))
+                    goto Lbail;
+                r[ci->a].i = normalize(ci->ty, n1 / n2);
+                break;
+            }
+
+            case CTFEmod:
+            {
+                sinteger_t n1 = r[ci->b].i;
+                sinteger_t n2 = r[ci->c].i;
+                if (n2 == 0)
+                    goto Lbail;
+                if (n2 == -1)
+                {   // int.min % -1 and long.min % -1 are errors
+                    if ((n1 == (sinteger_t)0xFFFFFFFF80000000ULL && ci->ty != Tint64) ||
+                        n1 == (sinteger_t)0x8000000000000000LL)
+                        goto Lbail;
+                }
+                r[ci->a].i = normalize(ci->ty, n1 % n2);
+                break;
+            }
+
+            case CTFEudiv:
+                if (r[ci->c].i == 0)
+                    goto Lbail;
+                r[ci->a].i = normalize(ci->ty, (d_uns64)r[ci->b].i / (d_uns64)r[ci->c].i);
+                break;
+
+            case CTFEumod:
+                if (r[ci->c].i == 0)
+                    goto Lbail;
+                r[ci->a].i = normalize(ci->ty, (d_uns64)r[ci->b].i % (d_uns64)r[ci->c].i);
+                break;
+
+            case CTFEshl:
+            case CTFEshr:
+            case CTFEushr:
+            {
+                sinteger_t count = r[ci->c].i;
+                if (count < 0 || count >= tysize(ci->ty1) * 8)
+                    goto Lbail;
+                dinteger_t value = r[ci->b].i;
+                if (ci->op == CTFEshl)
+                    value <<= count;
+                else if (ci->op == CTFEushr)
+                {
+                    if (tysize(ci->ty1) < 8)
+                        value &= (1ULL << (tysize(ci->ty1) * 8)) - 1;
+                    value >>= count;
+                }
+                else if (ci->ty1 == Tuns8 || ci->ty1 == Tchar ||
+                         ci->ty1 == Tuns16 || ci->ty1 == Twchar ||
+                         ci->ty1 == Tuns32 || ci->ty1 == Tdchar ||
+                         ci->ty1 == Tuns64 || ci->ty1 == Tbool)
+                    value >>= count;
+                else
+                    value = (sinteger_t)value >> count;
+                r[ci->a].i = normalize(ci->ty, value);
+                break;
+            }
+
+            case CTFEand:
+                r[ci->a].i = normalize(ci->ty, r[ci->b].i & r[ci->c].i);
+                break;
+
+            case CTFEor:
+                r[ci->a].i = normalize(ci->ty, r[ci->b].i | r[ci->c].i);
+                break;
+
+            case CTFExor:
+                r[ci->a].i = normalize(ci->ty, r[ci->b].i ^ r[ci->c].i);
+                break;
+
+            case CTFEneg:
+                r[ci->a].i = normalize(ci->ty, -r[ci->b].i);
+                break;
+
+            case CTFEcom:
+                r[ci->a].i = normalize(ci->ty, ~r[ci->b].i);
+                break;
+
+            case CTFEnot:
+                r[ci->a].i = r[ci->b].i == 0;
+                break;
+
+            case CTFEeq:  r[ci->a].i = r[ci->b].i == r[ci->c].i;  break;
+            case CTFEne:  r[ci->a].i = r[ci->b].i != r[ci->c].i;  break;
+            case CTFElt:  r[ci->a].i = (sinteger_t)r[ci->b].i <  (sinteger_t)r[ci->c].i;  break;
+            case CTFEle:  r[ci->a].i = (sinteger_t)r[ci->b].i <= (sinteger_t)r[ci->c].i;  break;
+            case CTFEgt:  r[ci->a].i = (sinteger_t)r[ci->b].i >  (sinteger_t)r[ci->c].i;  break;
+            case CTFEge:  r[ci->a].i = (sinteger_t)r[ci->b].i >= (sinteger_t)r[ci->c].i;  break;
+            case CTFEult: r[ci->a].i = r[ci->b].i <  r[ci->c].i;  break;
+            case CTFEule: r[ci->a].i = r[ci->b].i <= r[ci->c].i;  break;
+            case CTFEugt: r[ci->a].i = r[ci->b].i >  r[ci->c].i;  break;
+            case CTFEuge: r[ci->a].i = r[ci->b].i >= r[ci->c].i;  break;
+
+            case CTFEitof:
+                if (ci->ty1 == Tuns64)
+                    r[ci->a].f = ldouble((d_uns64)r[ci->b].i);
+                else
+                    r[ci->a].f = ldouble((d_int64)r[ci->b].i);
+                break;
+
+            case CTFEftoi:
+                r[ci->a].i = realToInteger(ci->ty, r[ci->b].f);
+                break;
+
+            case CTFEfadd:
+                r[ci->a].f = r[ci->b].f + r[ci->c].f;
+                break;
+
+            case CTFEfsub:
+                r[ci->a].f = r[ci->b].f - r[ci->c].f;
+                break;
+
+            case CTFEfmul:
+                r[ci->a].f = r[ci->b].f * r[ci->c].f;
+                break;
+
+            case CTFEfdiv:
+                r[ci->a].f = r[ci->b].f / r[ci->c].f;
+                break;
+
+            case CTFEfmod:
+                r[ci->a].f = Port::fmodl(r[ci->b].f, r[ci->c].f);
+                break;
+
+            case CTFEfneg:
+                r[ci->a].f = -r[ci->b].f;
+                break;
+
+            case CTFEfeq:
+                r[ci->a].i = !Port::isNan(r[ci->b].f) && !Port::isNan(r[ci->c].f) &&
+                             r[ci->b].f == r[ci->c].f;
+                break;
+
+            case CTFEfne:
+                r[ci->a].i = Port::isNan(r[ci->b].f) || Port::isNan(r[ci->c].f) ||
+                             r[ci->b].f != r[ci->c].f;
+                break;
+
+            case CTFEflt: r[ci->a].i = realCmp(TOKlt, r[ci->b].f, r[ci->c].f);  break;
+            case CTFEfle: r[ci->a].i = realCmp(TOKle, r[ci->b].f, r[ci->c].f);  break;
+            case CTFEfgt: r[ci->a].i = realCmp(TOKgt, r[ci->b].f, r[ci->c].f);  break;
+            case CTFEfge: r[ci->a].i = realCmp(TOKge, r[ci->b].f, r[ci->c].f);  break;
+
+            case CTFEjmp:
+                pc = ci->x;
+                break;
+
+            case CTFEjz:
+                if (!r[ci->a].i)
+                    pc = ci->x;
+                break;
+
+            case CTFEjnz:
+                if (r[ci->a].i)
+                    pc = ci->x;
+                break;
+
+            case CTFEldx:
+            {
+                d_uns64 i = r[ci->c].i;
+                if (i >= (d_uns64)ci->x)
+                    goto Lbail;
+                r[ci->a] = r[ci->b + i];
+                break;
+            }
+
+            case CTFEstx:
+            {
+                d_uns64 i = r[ci->c].i;
+                if (i >= (d_uns64)ci->x)
+                    goto Lbail;
+                if (tyreal(ci->ty))
+                    r[ci->a + i].f = r[ci->b].f;
+                else
+                    r[ci->a + i].i = normalize(ci->ty, r[ci->b].i);
+                break;
+            }
+
+            case CTFEfill:
+            {
+                CtfeValue v = r[ci->b];
+                if (!tyreal(ci->ty))
+                    v.i = normalize(ci->ty, v.i);
+                for (int i = 0; i < ci->x; i++)
+                    r[ci->a + i] = v;
+                break;
+            }
+
+            case CTFEcall:
+            {
+                FuncDeclaration *fd = bc->callees[ci->x];
+                CtfeCode *callee = getCtfeCode(fd);
+                if (!callee || callee->fallbacks)
+                {   /* The callee can't run as bytecode, so neither can we.
+                     * That is only for good if fd is done with semantic3,
+                     * and not just rerunning a bailed out call.
+                     */
+                    if (!callee && (fd->ctfeCode || fd->semanticRun != PASSsemantic3))
+                        bc->failed = true;
+                    goto Lbail;
+                }
+                size_t nargs = callee->func->parameters ? callee->func->parameters->dim : 0;
+                size_t newbase = ctfeRegsUsed;
+                reserveRegs(newbase + callee->nregs);
+                r = ctfeRegs + base;
+                for (size_t i = 0; i < nargs; i++)
+                    ctfeRegs[newbase + i] = r[ci->b + i];
+                CtfeValue result;
+                if (!execute(callee, newbase, &result))
+                    goto Lbail;
+                r = ctfeRegs + base;            // ctfeRegs may have moved
+                if (ci->a != -1)
+                {
+                    if (tyreal(ci->ty))
+                        r[ci->a] = result;
+                    else
+                        r[ci->a].i = normalize(ci->ty, result.i);
+                }
+                break;
+            }
+
+            case CTFEret:
+                if (ci->a == -1)
+                    presult->i = 0;
+                else if (tyreal(ci->ty))
+                    *presult = r[ci->a];
+                else
+                    presult->i = normalize(ci->ty, r[ci->a].i);
+                ctfeRegsUsed = oldUsed;
+                --CtfeStatus::callDepth;
+                return true;
+
+            case CTFEretx:
+                // The frame is left as it is until the caller has read it
+                presult->i = (r - ctfeRegs) + ci->a;
+                ctfeRegsUsed = oldUsed;
+                --CtfeStatus::callDepth;
+                return true;
+
+            case CTFEbail:
+                goto Lbail;
+
+            default:
+                assert(0);
+        }
+    }
+
+Lbail:
+    ctfeRegsUsed = oldUsed;
+    --CtfeStatus::callDepth;
+    return false;
+}
+
+/*************************************
+ * Run the function with the interpreted arguments.
+ * Return the result, EXP_VOID_INTERPRET if it is void,
+ * or NULL if the AST interpreter has to run the call instead.
+ */
+Expression *CtfeCode::run(Loc loc, Expressions *arguments)
+{
+    if (failed)
+        return NULL;
+
+    size_t nargs = arguments ? arguments->dim : 0;
+    for (size_t i = 0; i < nargs; i++)
+    {
+        VarDeclaration *v = (*func->parameters)[i];
+        if ((*arguments)[i]->op != (tyreal(tyof(v->type)) ? TOKfloat64 : TOKint64))
+            return NULL;
+    }
+
+    size_t base = ctfeRegsUsed;
+    reserveRegs(base + nregs);
+    for (size_t i = 0; i < nargs; i++)
+    {
+        VarDeclaration *v = (*func->parameters)[i];
+        unsigned char ty = tyof(v->type);
+        if (tyreal(ty))
+            ctfeRegs[base + i].f = (*arguments)[i]->toReal();
+        else
+            ctfeRegs[base + i].i = normalize(ty, (*arguments)[i]->toInteger());
+    }
+
+    CtfeValue result;
+    bool ok = execute(this, base, &result);
+
+    if (!ok)
+        return NULL;
+
+    // Only the result is boxed into an Expression
+    Type *tret = func->type->nextOf();
+    if (tret->toBasetype()->ty == Tvoid)
+        return EXP_VOID_INTERPRET;
+    size_t dim;
+    if (isScalarArray(tret, &dim))
+    {
+        Type *telem = tret->toBasetype()->nextOf();
+        Expressions *elements = new Expressions();
+        elements->setDim(dim);
+        for (size_t i = 0; i < dim; i++)
+        {
+            CtfeValue *v = &ctfeRegs[result.i + i];
+            if (telem->isreal())
+                (*elements)[i] = new RealExp(loc, v->f, telem);
+            else
+                (*elements)[i] = new IntegerExp(loc, v->i, telem);
+        }
+        ArrayLiteralExp *ae = new ArrayLiteralExp(loc, elements);
+        ae->type = tret;
+        ae->ownedByCtfe = true;
+        return ae;
+    }
+    if (tret->isreal())
+        return new RealExp(loc, result.f, tret);
+    return new IntegerExp(loc, result.i, tret);
+}
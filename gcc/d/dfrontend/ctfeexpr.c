@@ -13,6 +13,7 @@
 #include <string.h>                     // mem{cpy|set}()
 
 #include "rmem.h"
+#include "aav.h"
 
 #include "expression.h"
 #include "declaration.h"
@@ -20,6 +21,7 @@
 // for AssocArray
 #include "id.h"
 #include "template.h"
+#include "utf.h"
 #include "ctfe.h"
 
 #ifdef IN_GCC
@@ -365,6 +367,136 @@ Expression *copyLiteral(Expression *e)
     }
 }
 
+static Expression *copyOut(Expression *e, AA **pcopies);
+
+static bool copyOutArray(Expressions **pelems, AA **pcopies)
+{
+    Expressions *oldelems = *pelems;
+    if (!oldelems)
+        return true;
+    Expressions *newelems = new Expressions();
+    newelems->setDim(oldelems->dim);
+    for (size_t i = 0; i < oldelems->dim; i++)
+    {
+        Expression *m = (*oldelems)[i];
+        if (m && !(m = copyOut(m, pcopies)))
+            return false;
+        (*newelems)[i] = m;
+    }
+    *pelems = newelems;
+    return true;
+}
+
+static Expression *copyOut(Expression *e, AA **pcopies)
+{
+    switch (e->op)
+    {
+        // Leaves, which only refer to symbols and types
+        case TOKint64:
+        case TOKfloat64:
+        case TOKcomplex80:
+        case TOKnull:
+        case TOKvar:
+        case TOKsymoff:
+        case TOKfunction:
+        case TOKerror:
+            return e->copy();
+
+        case TOKstring:
+        case TOKarrayliteral:
+        case TOKassocarrayliteral:
+        case TOKstructliteral:
+        case TOKclassreference:
+        case TOKaddress:
+        case TOKdotvar:
+        case TOKdelegate:
+        case TOKcast:
+        case TOKvector:
+        case TOKindex:
+            break;
+
+        default:
+            return NULL;
+    }
+
+    // These may be shared, and must stay so
+    Expression **pr = (Expression **)_aaGet(pcopies, e);
+    if (*pr)
+        return *pr;
+    Expression *r = e->copy();
+    *pr = r;
+
+    switch (e->op)
+    {
+        case TOKstring:
+        {
+            StringExp *se = (StringExp *)r;
+            utf8_t *s = (utf8_t *)mem.calloc(se->len + 1, se->sz);
+            memcpy(s, se->string, se->len * se->sz);
+            se->string = s;
+            se->buffer = NULL;
+            return r;
+        }
+        case TOKarrayliteral:
+            if (!copyOutArray(&((ArrayLiteralExp *)r)->elements, pcopies))
+                return NULL;
+            return r;
+
+        case TOKassocarrayliteral:
+            if (!copyOutArray(&((AssocArrayLiteralExp *)r)->keys, pcopies) ||
+                !copyOutArray(&((AssocArrayLiteralExp *)r)->values, pcopies))
+                return NULL;
+            return r;
+
+        case TOKstructliteral:
+        {
+            StructLiteralExp *se = (StructLiteralExp *)r;
+            se->inlinecopy = NULL;
+            if (!copyOutArray(&se->elements, pcopies))
+                return NULL;
+            if (se->origin == e)
+                se->origin = se;
+            else if (se->origin &&
+                !(se->origin = (StructLiteralExp *)copyOut(se->origin, pcopies)))
+                return NULL;
+            return r;
+        }
+        case TOKclassreference:
+        {
+            ClassReferenceExp *cre = (ClassReferenceExp *)r;
+            if (!(cre->value = (StructLiteralExp *)copyOut(cre->value, pcopies)))
+                return NULL;
+            return r;
+        }
+        case TOKindex:
+        {
+            BinExp *be = (BinExp *)r;
+            if (!(be->e1 = copyOut(be->e1, pcopies)) ||
+                !(be->e2 = copyOut(be->e2, pcopies)))
+                return NULL;
+            return r;
+        }
+        default:
+        {
+            UnaExp *ue = (UnaExp *)r;
+            if (!(ue->e1 = copyOut(ue->e1, pcopies)))
+                return NULL;
+            return r;
+        }
+    }
+}
+
+/* Deep copy e, the scrubbed result of CTFE, out of the CTFE memory region
+ * before the region is released. Nodes shared within e are shared in the
+ * copy too. Return NULL if e contains something that can't be copied, in
+ * which case the region must be kept.
+ */
+Expression *copyOutOfRegion(Expression *e)
+{
+    AA *copies = NULL;
+    return copyOut(e, &copies);
+}
+
 /* Deal with type painting.
  * Type painting is a major nuisance: we can't just set
  * e->type = type, because that would change the original literal.
@@ -1693,11 +1825,360 @@ Expression *ctfeCat(Type *type, Expression *e1, Expression *e2)
     return Cat(type, e1, e2);
 }
 
+/* Returns the new value of ae1 ~= e2, where e2 is an element or an array
+ * literal of the same element type, in a CtfeArrayBuffer as for strings.
+ * Elements are copied as ctfeCat() copies them.
+ */
+static Expression *ctfeCatAssignArray(Type *type, ArrayLiteralExp *ae1, Expression *e2)
+{
+    Type *telem = ae1->type->toBasetype()->nextOf();
+    Expressions *elems2 = NULL;
+    if (e2->op == TOKarrayliteral && e2->type->toBasetype()->nextOf()->equals(telem))
+        elems2 = ((ArrayLiteralExp *)e2)->elements;
+    else if (!telem->equals(e2->type))
+        return ctfeCat(type, ae1, e2);
+
+    size_t len1 = ae1->elements->dim;
+    size_t len2 = elems2 ? elems2->dim : 1;
+    size_t len = len1 + len2;
+
+    CtfeArrayBuffer *buf = ae1->buffer;
+    if (!buf || buf->data != ae1->elements->data || buf->used != len1 ||
+        len > buf->capacity)
+    {
+        /* Move to a new buffer with room to grow. The old buffer is
+         * left alone, as other arrays may still be using it.
+         */
+        buf = new CtfeArrayBuffer();
+        buf->capacity = len < 16 ? 16 : len * 2;
+        buf->data = (Expression **)mem.malloc(buf->capacity * sizeof(Expression *));
+        for (size_t i = 0; i < len1; i++)
+        {
+            Expression *e = (*ae1->elements)[i];
+            buf->data[i] = elems2 ? copyLiteral(e) : e;
+        }
+    }
+
+    if (elems2)
+    {
+        for (size_t i = 0; i < len2; i++)
+            buf->data[len1 + i] = copyLiteral((*elems2)[i]);
+    }
+    else
+        buf->data[len1] = e2;
+    buf->used = len;
+
+    // A view of the first len elements of buf
+    Expressions *elements = new Expressions();
+    elements->data = buf->data;
+    elements->dim = len;
+
+    ArrayLiteralExp *ae = new ArrayLiteralExp(ae1->loc, elements);
+    ae->type = type;
+    ae->ownedByCtfe = true;
+    ae->buffer = buf;
+    return ae;
+}
+
+/* Returns the new value of e1 for e1 ~= e2.
+ * Appending a string or character to a string puts the result in a
+ * CtfeStringBuffer, and later appends to it fill up the spare capacity
+ * instead of copying the whole string again. Array literals do the same
+ * with a CtfeArrayBuffer.
+ */
+Expression *ctfeCatAssign(Type *type, Expression *e1, Expression *e2)
+{
+    if (e1->op == TOKarrayliteral && type->toBasetype()->ty == Tarray)
+        return ctfeCatAssignArray(type, (ArrayLiteralExp *)e1, e2);
+    if (e1->op != TOKstring || (e2->op != TOKstring && e2->op != TOKint64))
+        return ctfeCat(type, e1, e2);
+
+    StringExp *es1 = (StringExp *)e1;
+    size_t sz = es1->sz;
+    size_t len2;
+    dinteger_t v = 0;
+    bool homoConcat = true;
+    if (e2->op == TOKstring)
+    {
+        if (((StringExp *)e2)->sz != sz)
+            return ctfeCat(type, e1, e2);
+        len2 = ((StringExp *)e2)->len;
+    }
+    else
+    {
+        // char[] ~= char, or a character which needs encoding
+        v = e2->toInteger();
+        homoConcat = (sz == e2->type->toBasetype()->size());
+        len2 = homoConcat ? 1 : utf_codeLength(sz, v);
+    }
+    size_t len = es1->len + len2;
+
+    CtfeStringBuffer *buf = es1->buffer;
+    if (!buf || buf->data != es1->string || buf->used != es1->len ||
+        len > buf->capacity)
+    {
+        /* Move to a new buffer with room to grow. The old buffer is
+         * left alone, as other strings may still be using it.
+         */
+        buf = new CtfeStringBuffer();
+        buf->capacity = len < 16 ? 16 : len * 2;
+        buf->data = mem.malloc((buf->capacity + 1) * sz);
+        memcpy(buf->data, es1->string, es1->len * sz);
+    }
+
+    utf8_t *p = (utf8_t *)buf->data + es1->len * sz;
+    if (e2->op == TOKstring)
+        memcpy(p, ((StringExp *)e2)->string, len2 * sz);
+    else if (homoConcat)
+        memcpy(p, &v, sz);
+    else
+        utf_encode(sz, p, v);
+
+    // Add terminating 0
+    memset((utf8_t *)buf->data + len * sz, 0, sz);
+    buf->used = len;
+
+    StringExp *es = new StringExp(es1->loc, buf->data, len);
+    es->sz = sz;
+    es->committed = es1->committed;
+    if (e2->op == TOKstring)
+        es->committed |= ((StringExp *)e2)->committed;
+    es->type = type;
+    es->ownedByCtfe = true;
+    es->buffer = buf;
+    return es;
+}
+
+/******** Associative array index ***************************/
+
+/* CTFE associative arrays are AssocArrayLiteralExps, whose keys would
+ * otherwise have to be searched one by one with ctfeEqual.  Once an AA
+ * has grown past a few entries, an open addressing hash index over its
+ * keys is kept on the side.  The index is attached to the keys array, as
+ * several AssocArrayLiteralExps may share it.  It is built lazily, catches
+ * up with keys pushed onto the end of the array, and is thrown away
+ * whenever keys are removed or the AA escapes from CTFE.
+ */
+
+#define AAINDEX_MIN     8       // smaller AAs are searched linearly
+
+struct AAIndexSlot
+{
+    hash_t hash;
+    size_t pos;                 // position in keys[] + 1, 0 if empty
+};
+
+struct AAIndex
+{
+    size_t nindexed;            // keys[0 .. nindexed] are in the table
+    bool unhashable;            // a key can't be hashed, search linearly
+    size_t tabledim;            // always a power of 2
+    AAIndexSlot *table;
+};
+
+static AA *aaIndices;           // AAIndex* for each keys array
+
+static hash_t mixHash(hash_t h, dinteger_t v)
+{
+    v ^= v >> 33;
+    v *= 0xff51afd7ed558ccdULL;
+    v ^= v >> 33;
+    return (h ^ (hash_t)v) * 0x5bd1e995 + 0x9e3779b9;
+}
+
+/* Compute a hash of CTFE value e, consistent with ctfeEqual: any two
+ * values which compare equal hash the same.  Return false if e is of a
+ * kind that isn't hashed, such as floating point or reference types.
+ */
+static bool ctfeKeyHash(Expression *e, hash_t *phash)
+{
+    if (!e || !e->type)
+        return false;
+    Type *tb = e->type->toBasetype();
+    if (e->op == TOKclassreference || tb->ty == Tclass ||
+        tb->ty == Tpointer || tb->ty == Tdelegate)
+        return false;
+
+    if (isArray(e))
+    {
+        uinteger_t lo = 0;
+        uinteger_t len = resolveArrayLength(e);
+        Expression *x = e;
+        if (x->op == TOKslice)
+        {
+            lo = ((SliceExp *)x)->lwr->toInteger();
+            x = ((SliceExp *)x)->e1;
+        }
+
+        hash_t h = mixHash(0, len);
+        if (len == 0)
+            ;
+        else if (x->op == TOKstring)
+        {
+            StringExp *se = (StringExp *)x;
+            for (size_t i = 0; i < len; i++)
+                h = mixHash(h, se->charAt(lo + i));
+        }
+        else if (x->op == TOKarrayliteral)
+        {
+            ArrayLiteralExp *ae = (ArrayLiteralExp *)x;
+            for (size_t i = 0; i < len; i++)
+            {
+                Expression *ee = (*ae->elements)[lo + i];
+                if (ee && ee->type && ee->type->toBasetype()->isintegral())
+                {   // Same as the code units of a string with the same value
+                    h = mixHash(h, ee->toInteger());
+                    continue;
+                }
+                hash_t eh;
+                if (!ctfeKeyHash(ee, &eh))
+                    return false;
+                h = mixHash(h, eh);
+            }
+        }
+        else
+            return false;
+        *phash = h;
+        return true;
+    }
+
+    if (tb->isintegral())
+    {
+        *phash = mixHash(0, e->toInteger());
+        return true;
+    }
+
+    if (e->op == TOKstructliteral)
+    {
+        StructLiteralExp *se = (StructLiteralExp *)e;
+        hash_t h = mixHash(0, (dinteger_t)(size_t)se->sd);
+        size_t dim = se->elements ? se->elements->dim : 0;
+        for (size_t i = 0; i < dim; i++)
+        {
+            Expression *ee = (*se->elements)[i];
+            hash_t eh = 0;
+            if (ee && !ctfeKeyHash(ee, &eh))
+                return false;
+            h = mixHash(h, eh);
+        }
+        *phash = h;
+        return true;
+    }
+    return false;
+}
+
+static void aaIndexInsert(AAIndex *idx, hash_t hash, size_t pos)
+{
+    size_t mask = idx->tabledim - 1;
+    size_t i = hash & mask;
+    for (size_t j = 1; idx->table[i].pos; ++j)
+        i = (i + j) & mask;
+    idx->table[i].hash = hash;
+    idx->table[i].pos = pos + 1;
+}
+
+/* Add keys[nindexed .. keys->dim] to the index, growing it as needed.
+ * Returns false if one of the keys can't be hashed.
+ */
+static bool aaIndexUpdate(AAIndex *idx, Expressions *keys)
+{
+    if (idx->unhashable)
+        return false;
+
+    if (keys->dim * 2 > idx->tabledim)
+    {
+        // Rehash from scratch into a table of at most half load.
+        size_t dim = 16;
+        while (dim < keys->dim * 4)
+            dim <<= 1;
+        mem.free(idx->table);
+        idx->table = (AAIndexSlot *)mem.calloc(dim, sizeof(AAIndexSlot));
+        idx->tabledim = dim;
+        idx->nindexed = 0;
+    }
+
+    for (; idx->nindexed < keys->dim; idx->nindexed++)
+    {
+        hash_t hash;
+        if (!ctfeKeyHash((*keys)[idx->nindexed], &hash))
+        {
+            idx->unhashable = true;
+            return false;
+        }
+        aaIndexInsert(idx, hash, idx->nindexed);
+    }
+    return true;
+}
+
+/* Return the up to date index of keys, or NULL if keys should be
+ * searched linearly.
+ */
+static AAIndex *getAAIndex(Expressions *keys)
+{
+    if (!keys || keys->dim < AAINDEX_MIN)
+        return NULL;
+
+    AAIndex **pidx = (AAIndex **)_aaGet(&aaIndices, keys);
+    AAIndex *idx = *pidx;
+    if (!idx)
+    {
+        idx = new AAIndex();
+        *pidx = idx;
+    }
+    else if (idx->nindexed > keys->dim)
+        discardAAIndex(keys);
+
+    return aaIndexUpdate(idx, keys) ? idx : NULL;
+}
+
+void discardAAIndices()
+{
+    aaIndices = NULL;
+}
+
+void discardAAIndex(Expressions *keys)
+{
+    AAIndex *idx = (AAIndex *)_aaGetRvalue(aaIndices, keys);
+    if (idx)
+    {
+        mem.free(idx->table);
+        idx->table = NULL;
+        idx->tabledim = 0;
+        idx->nindexed = 0;
+        idx->unhashable = false;
+    }
+}
+
+/* Search idx for key e, which hashes to hash.  Return the position of the
+ * last equal key in keys + 1, or 0 if not found.
+ */
+static size_t aaIndexFind(Loc loc, AAIndex *idx, Expressions *keys, hash_t hash, Expression *e)
+{
+    size_t mask = idx->tabledim - 1;
+    size_t found = 0;
+    for (size_t i = hash & mask, j = 1; idx->table[i].pos; i = (i + j++) & mask)
+    {
+        AAIndexSlot *slot = &idx->table[i];
+        if (slot->hash == hash && slot->pos > found &&
+            ctfeEqual(loc, TOKequal, (*keys)[slot->pos - 1], e))
+            found = slot->pos;
+    }
+    return found;
+}
+
 /*  Given an AA literal 'ae', and a key 'e2':
  *  Return ae[e2] if present, or NULL if not found.
  */
 Expression *findKeyInAA(Loc loc, AssocArrayLiteralExp *ae, Expression *e2)
 {
+    hash_t hash;
+    AAIndex *idx = getAAIndex(ae->keys);
+    if (idx && ctfeKeyHash(e2, &hash))
+    {
+        size_t pos = aaIndexFind(loc, idx, ae->keys, hash, e2);
+        return pos ? (*ae->values)[pos - 1] : NULL;
+    }
+
     /* Search the keys backwards, in case there are duplicate keys
      */
     for (size_t i = ae->keys->dim; i;)
@@ -1713,6 +2194,67 @@ Expression *findKeyInAA(Loc loc, AssocArrayLiteralExp *ae, Expression *e2)
     return NULL;
 }
 
+/* Find the keys which are followed by an equal key, and so need removing
+ * from an AA literal.  Returns NULL if there are none, otherwise an array
+ * of keys->dim flags.
+ */
+bool *findDuplicateAAKeys(Loc loc, Expressions *keys)
+{
+    bool *dups = NULL;
+    if (keys->dim >= AAINDEX_MIN)
+    {
+        // Walk backwards, adding each key to a scratch index unless an
+        // equal key has already been seen.
+        AAIndex idx;
+        memset(&idx, 0, sizeof(AAIndex));
+        idx.tabledim = 16;
+        while (idx.tabledim < keys->dim * 2)
+            idx.tabledim <<= 1;
+        idx.table = (AAIndexSlot *)mem.calloc(idx.tabledim, sizeof(AAIndexSlot));
+
+        bool hashable = true;
+        for (size_t i = keys->dim; i; )
+        {
+            i--;
+            Expression *ekey = (*keys)[i];
+            hash_t hash;
+            if (!(hashable = ctfeKeyHash(ekey, &hash)))
+                break;
+            if (aaIndexFind(loc, &idx, keys, hash, ekey))
+            {
+                if (!dups)
+                    dups = (bool *)mem.calloc(keys->dim, sizeof(bool));
+                dups[i] = true;
+            }
+            else
+                aaIndexInsert(&idx, hash, i);
+        }
+        mem.free(idx.table);
+
+        if (hashable)
+            return dups;
+        // Hit a key that can't be hashed; start again the slow way.
+        mem.free(dups);
+        dups = NULL;
+    }
+
+    for (size_t i = 0; i < keys->dim; i++)
+    {
+        Expression *ekey = (*keys)[i];
+        for (size_t j = i + 1; j < keys->dim; j++)
+        {
+            if (ctfeEqual(loc, TOKequal, ekey, (*keys)[j]))
+            {
+                if (!dups)
+                    dups = (bool *)mem.calloc(keys->dim, sizeof(bool));
+                dups[i] = true;
+                break;
+            }
+        }
+    }
+    return dups;
+}
+
 /* Same as for constfold.Index, except that it only works for static arrays,
  * dynamic arrays, and strings. We know that e1 is an
  * interpreted CTFE expression, so it cannot have side-effects.
@@ -1867,37 +2409,6 @@ void recursiveBlockAssign(ArrayLiteralExp *ae, Expression *val, bool wantRef)
     }
 }
 
-// Duplicate the elements array, then set field 'indexToChange' = newelem.
-Expressions *changeOneElement(Expressions *oldelems, size_t indexToChange, Expression *newelem)
-{
-    Expressions *expsx = new Expressions();
-    ++CtfeStatus::numArrayAllocs;
-    expsx->setDim(oldelems->dim);
-    for (size_t j = 0; j < expsx->dim; j++)
-    {
-        if (j == indexToChange)
-            (*expsx)[j] = newelem;
-        else
-            (*expsx)[j] = (*oldelems)[j];
-    }
-    return expsx;
-}
-
-// Create a new struct literal, which is the same as se except that se.field[offset] = elem
-Expression * modifyStructField(Type *type, StructLiteralExp *se, size_t offset, Expression *newval)
-{
-    int fieldi = se->getFieldIndex(newval->type, offset);
-    if (fieldi == -1)
-        return EXP_CANT_INTERPRET;
-    /* Create new struct literal reflecting updated fieldi
-    */
-    Expressions *expsx = changeOneElement(se->elements, fieldi, newval);
-    StructLiteralExp * ee = new StructLiteralExp(se->loc, se->sd, expsx);
-    ee->type = se->type;
-    ee->ownedByCtfe = 1;
-    return ee;
-}
-
 // Given an AA literal aae,  set arr[index] = newval and return the new array.
 Expression *assignAssocArrayElement(Loc loc, AssocArrayLiteralExp *aae,
     Expression *index, Expression *newval)
@@ -1906,6 +2417,23 @@ Expression *assignAssocArrayElement(Loc loc, AssocArrayLiteralExp *aae,
      */
     Expressions *keysx = aae->keys;
     Expressions *valuesx = aae->values;
+
+    hash_t hash;
+    AAIndex *idx = getAAIndex(keysx);
+    if (idx && ctfeKeyHash(index, &hash))
+    {
+        // Keys are kept unique in CTFE, so there is only one to update.
+        size_t pos = aaIndexFind(loc, idx, keysx, hash, index);
+        if (pos)
+            (*valuesx)[pos - 1] = newval;
+        else
+        {
+            valuesx->push(newval);
+            keysx->push(index);
+        }
+        return newval;
+    }
+
     int updated = 0;
     for (size_t j = valuesx->dim; j; )
     {   j--;
@@ -11,6 +11,7 @@
 #include <stdio.h>
 #include <assert.h>
 
+#include "rmem.h"
 #include "init.h"
 #include "declaration.h"
 #include "attrib.h"
@@ -85,6 +86,7 @@ Declaration::Declaration(Identifier *id)
     inuse = 0;
     sem = SemanticStart;
     mangleOverride = NULL;
+    mangleString = NULL;
 }
 
 void Declaration::semantic(Scope *sc)
@@ -2112,6 +2114,7 @@ Expression *VarDeclaration::getConstInitializer(bool needFullType)
 
     if (scope)
     {
+        mem.pinRegion();        // init is kept, and may be reached from CTFE
         inuse++;
         init = init->semantic(scope, type, INITinterpret);
         scope = NULL;
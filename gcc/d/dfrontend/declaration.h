@@ -127,6 +127,7 @@ public:
     LINK linkage;
     int inuse;                  // used to detect cycles
     const char *mangleOverride;      // overridden symbol with pragma(mangle, "...")
+    const char *mangleString;        // cached result of mangle()
     Semantic sem;
 
     Declaration(Identifier *id);
@@ -635,6 +636,8 @@ public:
     int tookAddressOf;                  // set if someone took the address of
                                         // this function
     bool requiresClosure;               // this function needs a closure
+    bool scannedDelegates;              // scanLocalDelegates() has been run
+    const char *closureReason;          // why a closure is needed, for -fd-vclosure
     VarDeclarations closureVars;        // local variables in this function
                                         // which are referenced by nested
                                         // functions
@@ -715,6 +718,7 @@ public:
     FuncDeclaration *isUnique();
     void checkNestedReference(Scope *sc, Loc loc);
     bool needsClosure();
+    void scanLocalDelegates();
     bool hasNestedFrameRefs();
     void buildResultVar();
     Statement *mergeFrequire(Statement *);
@@ -384,27 +384,41 @@ void Module::gendocfile()
  */
 void escapeDdocString(OutBuffer *buf, size_t start)
 {
-    for (size_t u = start; u < buf->offset; u++)
+    size_t u = start;
+    for (; u < buf->offset; u++)
     {
         utf8_t c = buf->data[u];
+        if (c == '$' || c == '(' || c == ')')
+            break;
+    }
+    if (u == buf->offset)
+        return;
+
+    /* Copy out the rest of the text and append it back escaped,
+     * rather than inserting into buf for every character.
+     */
+    OutBuffer src;
+    src.write(buf->data + u, buf->offset - u);
+    buf->setsize(u);
+    for (u = 0; u < src.offset; u++)
+    {
+        utf8_t c = src.data[u];
         switch(c)
         {
             case '$':
-                buf->remove(u, 1);
-                buf->insert(u, "$(DOLLAR)", 9);
-                u += 8;
+                buf->writestring("$(DOLLAR)");
                 break;
 
             case '(':
-                buf->remove(u, 1); //remove the (
-                buf->insert(u, "$(LPAREN)", 9); //insert this instead
-                u += 8; //skip over newly inserted macro
+                buf->writestring("$(LPAREN)");
                 break;
 
             case ')':
-                buf->remove(u, 1); //remove the )
-                buf->insert(u, "$(RPAREN)", 9); //insert this instead
-                u += 8; //skip over newly inserted macro
+                buf->writestring("$(RPAREN)");
+                break;
+
+            default:
+                buf->writeByte(c);
                 break;
         }
     }
@@ -427,9 +441,15 @@ void escapeStrayParenthesis(OutBuffer *buf, size_t start, Dsymbol *s)
             loc = m->md->loc;
     }
 
-    for (size_t u = start; u < buf->offset; u++)
+    /* Copy out the text and append it back with the stray ')'
+     * replaced, rather than inserting into buf for each of them.
+     */
+    OutBuffer src;
+    src.write(buf->data + start, buf->offset - start);
+    buf->setsize(start);
+    for (size_t u = 0; u < src.offset; u++)
     {
-        utf8_t c = buf->data[u];
+        utf8_t c = src.data[u];
         switch(c)
         {
             case '(':
@@ -442,9 +462,8 @@ void escapeStrayParenthesis(OutBuffer *buf, size_t start, Dsymbol *s)
                     //stray ')'
                     warning(loc, "Ddoc: Stray ')'. This may cause incorrect Ddoc output."
                         " Use $(RPAREN) instead for unpaired right parentheses.");
-                    buf->remove(u, 1); //remove the )
-                    buf->insert(u, "$(RPAREN)", 9); //insert this instead
-                    u += 8; //skip over newly inserted macro
+                    buf->writestring("$(RPAREN)"); //insert this instead
+                    continue;
                 }
                 else
                     par_open--;
@@ -458,10 +477,18 @@ void escapeStrayParenthesis(OutBuffer *buf, size_t start, Dsymbol *s)
                 break;
 #endif
         }
+        buf->writeByte(c);
     }
 
     if (par_open)                       // if any unmatched lparens
-    {   par_open = 0;
+    {   /* There are par_open stray '(', find where they are
+         * and then replace them all in one copy.
+         */
+        size_t nstray = par_open;
+        size_t *stray = (size_t *)mem.malloc(nstray * sizeof(size_t));
+        size_t n = nstray;
+
+        par_open = 0;
         for (size_t u = buf->offset; u > start;)
         {   u--;
             utf8_t c = buf->data[u];
@@ -477,14 +504,29 @@ void escapeStrayParenthesis(OutBuffer *buf, size_t start, Dsymbol *s)
                         //stray '('
                         warning(loc, "Ddoc: Stray '('. This may cause incorrect Ddoc output."
                             " Use $(LPAREN) instead for unpaired left parentheses.");
-                        buf->remove(u, 1); //remove the (
-                        buf->insert(u, "$(LPAREN)", 9); //insert this instead
+                        assert(n > 0);
+                        stray[--n] = u;
                     }
                     else
                         par_open--;
                     break;
             }
         }
+        assert(n == 0);
+
+        src.setsize(0);
+        src.write(buf->data + start, buf->offset - start);
+        buf->setsize(start);
+        size_t last = 0;
+        for (size_t i = 0; i < nstray; i++)
+        {
+            size_t u = stray[i] - start;
+            buf->write(src.data + last, u - last);
+            buf->writestring("$(LPAREN)"); //insert this instead
+            last = u + 1;
+        }
+        buf->write(src.data + last, src.offset - last);
+        mem.free(stray);
     }
 }
 
@@ -2028,6 +2070,17 @@ TemplateParameter *isTemplateParameter(Dsymbol *s, utf8_t *p, size_t len)
     return NULL;
 }
 
+/****************************************************
+ * Append left, p[0..len] and right to buf.
+ */
+
+static void bracketText(OutBuffer *buf, const char *left, utf8_t *p, size_t len, const char *right)
+{
+    buf->writestring(left);
+    buf->write(p, len);
+    buf->writestring(right);
+}
+
 /**************************************************
  * Highlight text section.
  */
@@ -2043,38 +2096,57 @@ void highlightText(Scope *sc, Dsymbol *s, OutBuffer *buf, size_t offset)
     int leadingBlank = 1;
     int inCode = 0;
     //int inComment = 0;                  // in <!-- ... --> comment
-    size_t iCodeStart;                    // start of code section
+    size_t iCodeStart = 0;                // start of code section
     size_t codeIndent = 0;
 
     size_t iLineStart = offset;
 
-    for (size_t i = offset; i < buf->offset; i++)
-    {   utf8_t c = buf->data[i];
+    /* Copy out the text, and append it back onto buf as it is
+     * highlighted, rather than editing buf in place.  i indexes the
+     * text; iLineStart and iCodeStart are offsets into buf.
+     */
+    OutBuffer src;
+    src.reserve(buf->offset - offset + 1);
+    src.write(buf->data + offset, buf->offset - offset);
+    src.writeByte(0);                   // stop look ahead past the end
+    src.setsize(src.offset - 1);
+    buf->setsize(offset);
+
+    utf8_t *text = src.data;
+    size_t textlen = src.offset;
+
+    for (size_t i = 0; i < textlen; i++)
+    {   utf8_t c = text[i];
 
      Lcont:
         switch (c)
         {
             case ' ':
             case '\t':
+                buf->writeByte(c);
                 break;
 
             case '\n':
                 if (!sc->module->isDocFile &&
-                    !inCode && i == iLineStart && i + 1 < buf->offset)    // if "\n\n"
+                    !inCode && buf->offset == iLineStart && i + 1 < textlen)    // if "\n\n"
                 {
                     static char blankline[] = "$(DDOC_BLANKLINE)\n";
 
-                    i = buf->insert(i, blankline, strlen(blankline));
+                    buf->writestring(blankline);
                 }
+                buf->writeByte('\n');
                 leadingBlank = 1;
-                iLineStart = i + 1;
+                iLineStart = buf->offset;
                 break;
 
             case '<':
                 leadingBlank = 0;
                 if (inCode)
+                {
+                    buf->writeByte(c);
                     break;
-                p = &buf->data[i];
+                }
+                p = &text[i];
                 se = sc->module->escapetable->escapeChar('<');
 
                 if (se && strcmp(se, "&lt;") == 0)
@@ -2087,10 +2159,11 @@ void highlightText(Scope *sc, Dsymbol *s, OutBuffer *buf, size_t offset)
                         p += 4;
                         while (1)
                         {
-                            if (j == buf->offset)
+                            if (j == textlen)
                                 goto L1;
                             if (p[0] == '-' && p[1] == '-' && p[2] == '>')
                             {
+                                buf->write(text + i, j + 3 - i);
                                 i = j + 2;  // place on closing '>'
                                 break;
                             }
@@ -2107,10 +2180,14 @@ void highlightText(Scope *sc, Dsymbol *s, OutBuffer *buf, size_t offset)
                         p += 2;
                         while (1)
                         {
-                            if (j == buf->offset)
+                            if (j == textlen)
+                            {
+                                buf->writeByte(c);
                                 break;
+                            }
                             if (p[0] == '>')
                             {
+                                buf->write(text + i, j + 1 - i);
                                 i = j;      // place on closing '>'
                                 break;
                             }
@@ -2123,42 +2200,40 @@ void highlightText(Scope *sc, Dsymbol *s, OutBuffer *buf, size_t offset)
             L1:
                 // Replace '<' with '&lt;' character entity
                 if (se)
-                {   size_t len = strlen(se);
-                    buf->remove(i, 1);
-                    i = buf->insert(i, se, len);
-                    i--;        // point to ';'
-                }
+                    buf->writestring(se);
+                else
+                    buf->writeByte(c);
                 break;
 
             case '>':
                 leadingBlank = 0;
                 if (inCode)
+                {
+                    buf->writeByte(c);
                     break;
+                }
                 // Replace '>' with '&gt;' character entity
                 se = sc->module->escapetable->escapeChar('>');
                 if (se)
-                {   size_t len = strlen(se);
-                    buf->remove(i, 1);
-                    i = buf->insert(i, se, len);
-                    i--;        // point to ';'
-                }
+                    buf->writestring(se);
+                else
+                    buf->writeByte(c);
                 break;
 
             case '&':
                 leadingBlank = 0;
-                if (inCode)
+                p = &text[i];
+                if (inCode || p[1] == '#' || isalpha(p[1]))
+                {
+                    buf->writeByte(c);          // already a character entity
                     break;
-                p = &buf->data[i];
-                if (p[1] == '#' || isalpha(p[1]))
-                    break;                      // already a character entity
+                }
                 // Replace '&' with '&amp;' character entity
                 se = sc->module->escapetable->escapeChar('&');
                 if (se)
-                {   size_t len = strlen(se);
-                    buf->remove(i, 1);
-                    i = buf->insert(i, se, len);
-                    i--;        // point to ';'
-                }
+                    buf->writestring(se);
+                else
+                    buf->writeByte(c);
                 break;
 
             case '-':
@@ -2167,15 +2242,16 @@ void highlightText(Scope *sc, Dsymbol *s, OutBuffer *buf, size_t offset)
                  */
                 if (leadingBlank)
                 {   size_t istart = i;
+                    size_t iIndentEnd = buf->offset;
                     size_t eollen = 0;
 
                     leadingBlank = 0;
                     while (1)
                     {
                         ++i;
-                        if (i >= buf->offset)
+                        if (i >= textlen)
                             break;
-                        c = buf->data[i];
+                        c = text[i];
                         if (c == '\n')
                         {   eollen = 1;
                             break;
@@ -2183,127 +2259,142 @@ void highlightText(Scope *sc, Dsymbol *s, OutBuffer *buf, size_t offset)
                         if (c == '\r')
                         {
                             eollen = 1;
-                            if (i + 1 >= buf->offset)
+                            if (i + 1 >= textlen)
                                 break;
-                            if (buf->data[i + 1] == '\n')
+                            if (text[i + 1] == '\n')
                             {   eollen = 2;
                                 break;
                             }
                         }
                         // BUG: handle UTF PS and LS too
                         if (c != '-')
+                        {
+                            buf->write(text + istart, i - istart);
                             goto Lcont;
+                        }
                     }
                     if (i - istart < 3)
+                    {
+                        buf->write(text + istart, i - istart);
+                        if (i >= textlen)
+                            break;
                         goto Lcont;
+                    }
 
                     // We have the start/end of a code section
 
                     // Remove the entire --- line, including blanks and \n
-                    buf->remove(iLineStart, i - iLineStart + eollen);
-                    i = iLineStart;
+                    buf->setsize(iLineStart);
+                    i += eollen;        // first character after the line
 
-                    if (inCode && (i <= iCodeStart))
+                    if (inCode && (buf->offset <= iCodeStart))
                     {   // Empty code section, just remove it completely.
                         inCode = 0;
+                        // The character after the line is not looked at.
+                        if (i < textlen)
+                            buf->writeByte(text[i]);
                         break;
                     }
 
                     if (inCode)
                     {
                         inCode = 0;
-                        // The code section is from iCodeStart to i
+                        // The code section is from iCodeStart to the end of buf
                         OutBuffer codebuf;
-
-                        codebuf.write(buf->data + iCodeStart, i - iCodeStart);
-                        codebuf.writeByte(0);
+                        codebuf.reserve(buf->offset - iCodeStart + 1);
 
                         // Remove leading indentations from all lines
                         bool lineStart = true;
-                        utf8_t *endp = codebuf.data + codebuf.offset;
-                        for (utf8_t *p = codebuf.data; p < endp; )
+                        utf8_t *endp = buf->data + buf->offset;
+                        for (utf8_t *p = buf->data + iCodeStart; p < endp; )
                         {
                             if (lineStart)
                             {
                                 size_t j = codeIndent;
-                                utf8_t *q = p;
-                                while (j-- > 0 && q < endp && isIndentWS(q))
-                                    ++q;
-                                codebuf.remove(p - codebuf.data, q - p);
-                                assert(codebuf.data <= p);
-                                assert(p < codebuf.data + codebuf.offset);
+                                while (j-- > 0 && p < endp && isIndentWS(p))
+                                    ++p;
                                 lineStart = false;
-                                endp = codebuf.data + codebuf.offset; // update
                                 continue;
                             }
                             if (*p == '\n')
                                 lineStart = true;
+                            codebuf.writeByte(*p);
                             ++p;
                         }
+                        codebuf.writeByte(0);
 
                         highlightCode2(sc, s, &codebuf, 0);
-                        buf->remove(iCodeStart, i - iCodeStart);
-                        i = buf->insert(iCodeStart, codebuf.data, codebuf.offset);
-                        i = buf->insert(i, ")\n", 2);
-                        i -= 2; // in next loop, c should be '\n'
+                        buf->setsize(iCodeStart);
+                        buf->write(codebuf.data, codebuf.offset);
+                        buf->writeByte(')');
+
+                        // Carry on with a '\n' ending the code section
+                        i--;
+                        c = '\n';
+                        goto Lcont;
                     }
                     else
                     {   static char pre[] = "$(D_CODE \n";
 
                         inCode = 1;
-                        codeIndent = istart - iLineStart;  // save indent count
-                        i = buf->insert(i, pre, strlen(pre));
-                        iCodeStart = i;
-                        i--;            // place i on >
+                        codeIndent = iIndentEnd - iLineStart;  // save indent count
+                        buf->writestring(pre);
+                        iCodeStart = buf->offset;
+                        i--;            // next loop looks at the character after the line
                         leadingBlank = true;
                     }
                 }
+                else
+                    buf->writeByte(c);
                 break;
 
             default:
                 leadingBlank = 0;
                 if (!sc->module->isDocFile &&
-                    !inCode && isIdStart(&buf->data[i]))
+                    !inCode && isIdStart(&text[i]))
                 {
-                    size_t j = skippastident(buf, i);
+                    size_t j = skippastident(&src, i);
                     if (j > i)
                     {
-                        size_t k = skippastURL(buf, i);
+                        size_t k = skippastURL(&src, i);
                         if (k > i)
-                        {   i = k - 1;
+                        {
+                            buf->write(text + i, k - i);
+                            i = k - 1;
                             break;
                         }
 
-                        if (buf->data[i] == '_')        // leading '_' means no highlight
+                        if (text[i] == '_')        // leading '_' means no highlight
                         {
-                            buf->remove(i, 1);
-                            i = j - 1;
+                            buf->write(text + i + 1, j - i - 1);
+                            // The character after the identifier is not looked at.
+                            if (j < textlen)
+                                buf->writeByte(text[j]);
+                            i = j;
                         }
                         else
                         {
-                            if (cmp(sid, buf->data + i, j - i) == 0)
+                            if (cmp(sid, text + i, j - i) == 0)
                             {
-                                i = buf->bracket(i, "$(DDOC_PSYMBOL ", j, ")") - 1;
-                                break;
+                                bracketText(buf, "$(DDOC_PSYMBOL ", text + i, j - i, ")");
                             }
-                            else if (isKeyword(buf->data + i, j - i))
+                            else if (isKeyword(text + i, j - i))
                             {
-                                i = buf->bracket(i, "$(DDOC_KEYWORD ", j, ")") - 1;
-                                break;
+                                bracketText(buf, "$(DDOC_KEYWORD ", text + i, j - i, ")");
                             }
-                            else
+                            else if (f && isFunctionParameter(f, text + i, j - i))
                             {
-                                if (f && isFunctionParameter(f, buf->data + i, j - i))
-                                {
-                                    //printf("highlighting arg '%s', i = %d, j = %d\n", arg->ident->toChars(), i, j);
-                                    i = buf->bracket(i, "$(DDOC_PARAM ", j, ")") - 1;
-                                    break;
-                                }
+                                //printf("highlighting arg '%s', i = %d, j = %d\n", arg->ident->toChars(), i, j);
+                                bracketText(buf, "$(DDOC_PARAM ", text + i, j - i, ")");
                             }
+                            else
+                                buf->write(text + i, j - i);
                             i = j - 1;
                         }
+                        break;
                     }
                 }
+                buf->writeByte(c);
                 break;
         }
     }
@@ -2318,52 +2409,49 @@ void highlightText(Scope *sc, Dsymbol *s, OutBuffer *buf, size_t offset)
 
 void highlightCode(Scope *sc, Dsymbol *s, OutBuffer *buf, size_t offset, bool anchor)
 {
-    if (anchor)
-    {
-        OutBuffer ancbuf;
+    /* Copy out the code, and append it back onto buf as it is
+     * highlighted, rather than editing buf in place.
+     */
+    OutBuffer src;
+    src.write(buf->data + offset, buf->offset - offset);
+    buf->setsize(offset);
 
-        emitAnchor(&ancbuf, s);
-        buf->insert(offset, (char *)ancbuf.data, ancbuf.offset);
-        offset += ancbuf.offset;
-    }
+    if (anchor)
+        emitAnchor(buf, s);
     char *sid = s->ident->toChars();
     FuncDeclaration *f = s->isFuncDeclaration();
+    utf8_t *text = src.data;
 
     //printf("highlightCode(s = '%s', kind = %s)\n", sid, s->kind());
-    for (size_t i = offset; i < buf->offset; i++)
-    {   utf8_t c = buf->data[i];
+    for (size_t i = 0; i < src.offset; i++)
+    {   utf8_t c = text[i];
         const char *se;
 
         se = sc->module->escapetable->escapeChar(c);
         if (se)
         {
-            size_t len = strlen(se);
-            buf->remove(i, 1);
-            i = buf->insert(i, se, len);
-            i--;                // point to ';'
+            buf->writestring(se);
+            continue;
         }
-        else if (isIdStart(&buf->data[i]))
+        else if (isIdStart(&text[i]))
         {
-            size_t j = skippastident(buf, i);
+            size_t j = skippastident(&src, i);
             if (j > i)
             {
-                if (cmp(sid, buf->data + i, j - i) == 0)
+                if (cmp(sid, text + i, j - i) == 0)
+                    bracketText(buf, "$(DDOC_PSYMBOL ", text + i, j - i, ")");
+                else if (f && isFunctionParameter(f, text + i, j - i))
                 {
-                    i = buf->bracket(i, "$(DDOC_PSYMBOL ", j, ")") - 1;
-                    continue;
-                }
-                else if (f)
-                {
-                    if (isFunctionParameter(f, buf->data + i, j - i))
-                    {
-                        //printf("highlighting arg '%s', i = %d, j = %d\n", arg->ident->toChars(), i, j);
-                        i = buf->bracket(i, "$(DDOC_PARAM ", j, ")") - 1;
-                        continue;
-                    }
+                    //printf("highlighting arg '%s', i = %d, j = %d\n", arg->ident->toChars(), i, j);
+                    bracketText(buf, "$(DDOC_PARAM ", text + i, j - i, ")");
                 }
+                else
+                    buf->write(text + i, j - i);
                 i = j - 1;
+                continue;
             }
         }
+        buf->writeByte(c);
     }
 }
 
@@ -41,6 +41,7 @@ const char* Pprotectionnames[] = {NULL, "none", "private", "package", "protected
 Dsymbol::Dsymbol()
 {
     //printf("Dsymbol::Dsymbol(%p)\n", this);
+    mem.pinRegion();
     this->ident = NULL;
     this->parent = NULL;
     this->csym = NULL;
@@ -53,11 +54,13 @@ Dsymbol::Dsymbol()
     this->depmsg = NULL;
     this->userAttributes = NULL;
     this->ddocUnittest = NULL;
+    this->prettystring = NULL;
 }
 
 Dsymbol::Dsymbol(Identifier *ident)
 {
     //printf("Dsymbol::Dsymbol(%p, ident)\n", this);
+    mem.pinRegion();
     this->ident = ident;
     this->parent = NULL;
     this->csym = NULL;
@@ -70,6 +73,7 @@ Dsymbol::Dsymbol(Identifier *ident)
     this->depmsg = NULL;
     this->userAttributes = NULL;
     this->ddocUnittest = NULL;
+    this->prettystring = NULL;
 }
 
 bool Dsymbol::equals(RootObject *o)
@@ -198,6 +202,23 @@ Identifier *Dsymbol::getIdent()
     return ident;
 }
 
+/*************************************
+ * Return a copy of s[0..len] from a table shared by all symbols,
+ * so that names cached on symbols are only stored once.
+ */
+
+const char *Dsymbol::internString(const char *s, size_t len)
+{
+    static StringTable *nametable;
+
+    if (!nametable)
+    {
+        nametable = new StringTable();
+        nametable->_init();
+    }
+    return nametable->update(s, len)->toDchars();
+}
+
 char *Dsymbol::toChars()
 {
     return ident ? ident->toChars() : (char *)"__anonymous";
@@ -210,12 +231,23 @@ const char *Dsymbol::toPrettyChars()
     size_t len;
 
     //printf("Dsymbol::toPrettyChars() '%s'\n", toChars());
+    if (prettystring)
+        return prettystring;
     if (!parent)
         return toChars();
 
+    /* The name can only be cached once the arguments of all
+     * enclosing template instances are known.
+     */
+    bool stable = true;
     len = 0;
     for (p = this; p; p = p->parent)
+    {
+        TemplateInstance *ti = p->isTemplateInstance();
+        if (ti && ti->semanticRun < PASSsemanticdone)
+            stable = false;
         len += strlen(p->toChars()) + 1;
+    }
 
     s = (char *)mem.malloc(len);
     q = s + len - 1;
@@ -231,6 +263,12 @@ const char *Dsymbol::toPrettyChars()
         q--;
         *q = '.';
     }
+    if (stable)
+    {
+        prettystring = internString(s, strlen(s));
+        mem.free(s);
+        return prettystring;
+    }
     return s;
 }
 
@@ -830,6 +868,20 @@ const char *OverloadSet::kind()
 
 /********************************* ScopeDsymbol ****************************/
 
+unsigned ScopeDsymbol::searchEpoch;
+unsigned ScopeDsymbol::searchCutoffs;
+
+/* Result of ScopeDsymbol::searchImports(), chained per identifier
+ * in ScopeDsymbol::searchCache.
+ */
+struct SearchCacheEntry
+{
+    SearchCacheEntry *next;     // entry for the same identifier, other flags
+    int flags;
+    unsigned epoch;             // value of searchEpoch when s was found
+    Dsymbol *s;
+};
+
 ScopeDsymbol::ScopeDsymbol()
     : Dsymbol()
 {
@@ -837,6 +889,7 @@ ScopeDsymbol::ScopeDsymbol()
     symtab = NULL;
     imports = NULL;
     prots = NULL;
+    searchCache = NULL;
 }
 
 ScopeDsymbol::ScopeDsymbol(Identifier *id)
@@ -846,6 +899,7 @@ ScopeDsymbol::ScopeDsymbol(Identifier *id)
     symtab = NULL;
     imports = NULL;
     prots = NULL;
+    searchCache = NULL;
 }
 
 Dsymbol *ScopeDsymbol::syntaxCopy(Dsymbol *s)
@@ -883,104 +937,43 @@ Dsymbol *ScopeDsymbol::search(Loc loc, Identifier *ident, int flags)
         return NULL;
     else
     {
-        Dsymbol *s = NULL;
-        OverloadSet *a = NULL;
+        /* Reuse the result of an earlier search of the imports, as long as
+         * no imported scope has changed since.
+         */
+        SearchCacheEntry *ce = (SearchCacheEntry *)_aaGetRvalue(searchCache, (Key)ident);
+        while (ce && ce->flags != flags)
+            ce = ce->next;
 
-        // Look in imported modules
-        for (size_t i = 0; i < imports->dim; i++)
+        Dsymbol *s;
+        if (ce && ce->epoch == searchEpoch)
+            s = ce->s;
+        else
         {
-            // If private import, don't search it
-            if (flags & 1 && prots[i] == PROTprivate)
-                continue;
+            unsigned epoch = searchEpoch;
+            unsigned cutoffs = searchCutoffs;
+            unsigned errors = global.errors;
 
-            Dsymbol *ss = (*imports)[i];
+            s = searchImports(loc, ident, flags);
 
-            //printf("\tscanning import '%s', prots = %d, isModule = %p, isImport = %p\n", ss->toChars(), prots[i], ss->isModule(), ss->isImport());
-            /* Don't find private members if ss is a module
+            /* Don't remember results that are missing symbols because of
+             * a circular import, or whose errors would not be repeated.
              */
-            Dsymbol *s2 = ss->search(loc, ident, ss->isModule() ? 1 : 0);
-            if (!s)
-                s = s2;
-            else if (s2 && s != s2)
+            if (cutoffs == searchCutoffs && errors == global.errors)
             {
-                if (s->toAlias() == s2->toAlias() ||
-                    s->getType() == s2->getType() && s->getType())
-                {
-                    /* After following aliases, we found the same
-                     * symbol, so it's not an ambiguity.  But if one
-                     * alias is deprecated or less accessible, prefer
-                     * the other.
-                     */
-                    if (s->isDeprecated() ||
-                        s2->prot() > s->prot() && s2->prot() != PROTnone)
-                        s = s2;
-                }
-                else
+                if (!ce)
                 {
-                    /* Two imports of the same module should be regarded as
-                     * the same.
-                     */
-                    Import *i1 = s->isImport();
-                    Import *i2 = s2->isImport();
-                    if (!(i1 && i2 &&
-                          (i1->mod == i2->mod ||
-                           (!i1->parent->isImport() && !i2->parent->isImport() &&
-                            i1->ident->equals(i2->ident))
-                          )
-                         )
-                       )
-                    {
-                        /* Bugzilla 8668:
-                         * Public selective import adds AliasDeclaration in module.
-                         * To make an overload set, resolve aliases in here and
-                         * get actual overload roots which accessible via s and s2.
-                         */
-                        s = s->toAlias();
-                        s2 = s2->toAlias();
-
-                        /* If both s2 and s are overloadable (though we only
-                         * need to check s once)
-                         */
-                        if (s2->isOverloadable() && (a || s->isOverloadable()))
-                        {   if (!a)
-                            {
-                                a = new OverloadSet(s->ident);
-                                a->parent = this;
-                            }
-                            /* Don't add to a[] if s2 is alias of previous sym
-                             */
-                            for (size_t j = 0; j < a->a.dim; j++)
-                            {   Dsymbol *s3 = a->a[j];
-                                if (s2->toAlias() == s3->toAlias())
-                                {
-                                    if (s3->isDeprecated() ||
-                                        s2->prot() > s3->prot() && s2->prot() != PROTnone)
-                                        a->a[j] = s2;
-                                    goto Lcontinue;
-                                }
-                            }
-                            a->push(s2);
-                        Lcontinue:
-                            continue;
-                        }
-                        if (flags & 4)          // if return NULL on ambiguity
-                            return NULL;
-                        if (!(flags & 2))
-                            ScopeDsymbol::multiplyDefined(loc, s, s2);
-                        break;
-                    }
+                    mem.pinRegion();
+                    ce = new SearchCacheEntry();
+                    ce->flags = flags;
+                    SearchCacheEntry **pce = (SearchCacheEntry **)_aaGet(&searchCache, (Key)ident);
+                    ce->next = *pce;
+                    *pce = ce;
                 }
+                ce->s = s;
+                ce->epoch = epoch;
             }
         }
 
-        /* Build special symbol if we had multiple finds
-         */
-        if (a)
-        {   assert(s);
-            a->push(s);
-            s = a;
-        }
-
         if (s)
         {
             if (!(flags & 2) && s->prot() == PROTprivate && !s->parent->isTemplateMixin())
@@ -993,6 +986,113 @@ Dsymbol *ScopeDsymbol::search(Loc loc, Identifier *ident, int flags)
     }
 }
 
+/*****************************************
+ * Search the imported scopes of this scope for ident.
+ */
+
+Dsymbol *ScopeDsymbol::searchImports(Loc loc, Identifier *ident, int flags)
+{
+    Dsymbol *s = NULL;
+    OverloadSet *a = NULL;
+
+    // Look in imported modules
+    for (size_t i = 0; i < imports->dim; i++)
+    {
+        // If private import, don't search it
+        if (flags & 1 && prots[i] == PROTprivate)
+            continue;
+
+        Dsymbol *ss = (*imports)[i];
+
+        //printf("\tscanning import '%s', prots = %d, isModule = %p, isImport = %p\n", ss->toChars(), prots[i], ss->isModule(), ss->isImport());
+        /* Don't find private members if ss is a module
+         */
+        Dsymbol *s2 = ss->search(loc, ident, ss->isModule() ? 1 : 0);
+        if (!s)
+            s = s2;
+        else if (s2 && s != s2)
+        {
+            if (s->toAlias() == s2->toAlias() ||
+                s->getType() == s2->getType() && s->getType())
+            {
+                /* After following aliases, we found the same
+                 * symbol, so it's not an ambiguity.  But if one
+                 * alias is deprecated or less accessible, prefer
+                 * the other.
+                 */
+                if (s->isDeprecated() ||
+                    s2->prot() > s->prot() && s2->prot() != PROTnone)
+                    s = s2;
+            }
+            else
+            {
+                /* Two imports of the same module should be regarded as
+                 * the same.
+                 */
+                Import *i1 = s->isImport();
+                Import *i2 = s2->isImport();
+                if (!(i1 && i2 &&
+                      (i1->mod == i2->mod ||
+                       (!i1->parent->isImport() && !i2->parent->isImport() &&
+                        i1->ident->equals(i2->ident))
+                      )
+                     )
+                   )
+                {
+                    /* Bugzilla 8668:
+                     * Public selective import adds AliasDeclaration in module.
+                     * To make an overload set, resolve aliases in here and
+                     * get actual overload roots which accessible via s and s2.
+                     */
+                    s = s->toAlias();
+                    s2 = s2->toAlias();
+
+                    /* If both s2 and s are overloadable (though we only
+                     * need to check s once)
+                     */
+                    if (s2->isOverloadable() && (a || s->isOverloadable()))
+                    {   if (!a)
+                        {
+                            a = new OverloadSet(s->ident);
+                            a->parent = this;
+                        }
+                        /* Don't add to a[] if s2 is alias of previous sym
+                         */
+                        for (size_t j = 0; j < a->a.dim; j++)
+                        {   Dsymbol *s3 = a->a[j];
+                            if (s2->toAlias() == s3->toAlias())
+                            {
+                                if (s3->isDeprecated() ||
+                                    s2->prot() > s3->prot() && s2->prot() != PROTnone)
+                                    a->a[j] = s2;
+                                goto Lcontinue;
+                            }
+                        }
+                        a->push(s2);
+                    Lcontinue:
+                        continue;
+                    }
+                    if (flags & 4)          // if return NULL on ambiguity
+                        return NULL;
+                    if (!(flags & 2))
+                        ScopeDsymbol::multiplyDefined(loc, s, s2);
+                    break;
+                }
+            }
+        }
+    }
+
+    /* Build special symbol if we had multiple finds
+     */
+    if (a)
+    {   assert(s);
+        a->push(s);
+        s = a;
+    }
+
+    return s;
+}
+
 void ScopeDsymbol::importScope(Dsymbol *s, PROT protection)
 {
     //printf("%s->ScopeDsymbol::importScope(%s, %d)\n", toChars(), s->toChars(), protection);
@@ -1000,6 +1100,7 @@ void ScopeDsymbol::importScope(Dsymbol *s, PROT protection)
     // No circular or redundant import's
     if (s != this)
     {
+        searchEpoch++;
         if (!imports)
             imports = new Dsymbols();
         else
@@ -1086,6 +1187,11 @@ const char *ScopeDsymbol::kind()
 
 Dsymbol *ScopeDsymbol::symtabInsert(Dsymbol *s)
 {
+    /* Only modules and mixins are imported, don't invalidate
+     * the search caches for symbols local to a function.
+     */
+    if (isModule() || isTemplateMixin())
+        searchEpoch++;
     return symtab->insert(s);
 }
 
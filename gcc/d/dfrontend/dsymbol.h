@@ -129,9 +129,11 @@ public:
     char *depmsg;               // customized deprecation message
     Expressions *userAttributes;        // user defined attributes from UserAttributeDeclaration
     UnitTestDeclaration *ddocUnittest; // !=NULL means there's a ddoc unittest associated with this symbol (only use this with ddoc)
+    const char *prettystring;   // cached result of toPrettyChars()
 
     Dsymbol();
     Dsymbol(Identifier *);
+    static const char *internString(const char *s, size_t len);
     char *toChars();
     Loc& getLoc();
     char *locToChars();
@@ -273,11 +275,16 @@ public:
 
     Dsymbols *imports;          // imported Dsymbol's
     unsigned char *prots;       // array of PROT, one for each import
+    AA *searchCache;            // previous results of searching imports[]
+
+    static unsigned searchEpoch;   // bumped when any imported scope changes
+    static unsigned searchCutoffs; // number of searches cut short by Module::insearch
 
     ScopeDsymbol();
     ScopeDsymbol(Identifier *id);
     Dsymbol *syntaxCopy(Dsymbol *s);
     Dsymbol *search(Loc loc, Identifier *ident, int flags);
+    Dsymbol *searchImports(Loc loc, Identifier *ident, int flags);
     void importScope(Dsymbol *s, PROT protection);
     bool isforwardRef();
     void defineRef(Dsymbol *s);
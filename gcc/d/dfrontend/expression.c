@@ -3958,6 +3958,7 @@ StringExp::StringExp(Loc loc, char *string)
     this->committed = 0;
     this->postfix = 0;
     this->ownedByCtfe = false;
+    this->buffer = NULL;
 }
 
 StringExp::StringExp(Loc loc, void *string, size_t len)
@@ -3969,6 +3970,7 @@ StringExp::StringExp(Loc loc, void *string, size_t len)
     this->committed = 0;
     this->postfix = 0;
     this->ownedByCtfe = false;
+    this->buffer = NULL;
 }
 
 StringExp::StringExp(Loc loc, void *string, size_t len, utf8_t postfix)
@@ -3980,6 +3982,7 @@ StringExp::StringExp(Loc loc, void *string, size_t len, utf8_t postfix)
     this->committed = 0;
     this->postfix = postfix;
     this->ownedByCtfe = false;
+    this->buffer = NULL;
 }
 
 #if 0
@@ -4362,6 +4365,8 @@ ArrayLiteralExp::ArrayLiteralExp(Loc loc, Expressions *elements)
 {
     this->elements = elements;
     this->ownedByCtfe = false;
+    this->onstack = 0;
+    this->buffer = NULL;
 }
 
 ArrayLiteralExp::ArrayLiteralExp(Loc loc, Expression *e)
@@ -4370,6 +4375,8 @@ ArrayLiteralExp::ArrayLiteralExp(Loc loc, Expression *e)
     elements = new Expressions;
     elements->push(e);
     this->ownedByCtfe = false;
+    this->onstack = 0;
+    this->buffer = NULL;
 }
 
 bool ArrayLiteralExp::equals(RootObject *o)
@@ -48,6 +48,8 @@ struct Symbol;          // back end symbol
 class OverloadSet;
 class Initializer;
 class StringExp;
+struct CtfeStringBuffer;
+struct CtfeArrayBuffer;
 class ArrayExp;
 class SliceExp;
 
@@ -406,6 +408,7 @@ public:
     unsigned char committed;    // !=0 if type is committed
     utf8_t postfix;      // 'c', 'w', 'd'
     bool ownedByCtfe;   // true = created in CTFE
+    CtfeStringBuffer *buffer;   // room to grow in CTFE, NULL if none
 
     StringExp(Loc loc, char *s);
     StringExp(Loc loc, void *s, size_t len);
@@ -470,6 +473,8 @@ class ArrayLiteralExp : public Expression
 public:
     Expressions *elements;
     bool ownedByCtfe;   // true = created in CTFE
+    int onstack;        // cannot escape, so allocate on stack
+    CtfeArrayBuffer *buffer;    // room to grow in CTFE, NULL if none
 
     ArrayLiteralExp(Loc loc, Expressions *elements);
     ArrayLiteralExp(Loc loc, Expression *e);
@@ -511,6 +516,7 @@ public:
     Expression *semantic(Scope *sc);
     int isBool(int result);
     elem *toElem(IRState *irs);
+    dt_t **toDt(dt_t **pdt);
     void toCBuffer(OutBuffer *buf, HdrGenState *hgs);
     void toMangleBuffer(OutBuffer *buf);
     Expression *optimize(int result, bool keepLvalue = false);
@@ -98,7 +98,7 @@ int File::read()
     }
 
     if (!ref)
-        ::free(buffer);
+        mem.free(buffer);
     ref = 0;       // we own the buffer now
 
     //printf("\tfile opened\n");
@@ -108,7 +108,7 @@ int File::read()
         goto err2;
     }
     size = buf.st_size;
-    buffer = (utf8_t *) ::malloc(size + 2);
+    buffer = (utf8_t *)mem.malloc(size + 2);
     if (!buffer)
     {
         printf("\tmalloc error, errno = %d\n",errno);
@@ -141,7 +141,7 @@ int File::read()
 err2:
     close(fd);
 err:
-    ::free(buffer);
+    mem.free(buffer);
     buffer = NULL;
     len = 0;
 
@@ -162,11 +162,11 @@ err1:
         goto err1;
 
     if (!ref)
-        ::free(buffer);
+        mem.free(buffer);
     ref = 0;
 
     size = GetFileSize(h,NULL);
-    buffer = (utf8_t *) ::malloc(size + 2);
+    buffer = (utf8_t *)mem.malloc(size + 2);
     if (!buffer)
         goto err2;
 
@@ -195,7 +195,7 @@ err1:
 err2:
     CloseHandle(h);
 err:
-    ::free(buffer);
+    mem.free(buffer);
     buffer = NULL;
     len = 0;
 
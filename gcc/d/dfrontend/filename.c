@@ -16,6 +16,7 @@
 #include "array.h"
 #include "file.h"
 #include "rmem.h"
+#include "stringtable.h"
 
 #if defined (__sun)
 #include <alloca.h>
@@ -41,6 +42,13 @@
 #include <utime.h>
 #endif
 
+#if POSIX && !__APPLE__
+// Directory listings can be compared exactly against file names
+// only where the file system is case sensitive.
+#define USE_DIR_CACHE 1
+#include <dirent.h>
+#endif
+
 /****************************** FileName ********************************/
 
 FileName::FileName(const char *str)
@@ -566,6 +574,102 @@ int FileName::exists(const char *name)
 #endif
 }
 
+/*************************************
+ * Same as exists(), but answered from a cache of directory listings, so
+ * that each directory is read only once no matter how many names in it
+ * are asked about.  The cache is never invalidated, so this must only be
+ * used for files that the compiler does not create itself, such as the
+ * source files searched for along the import path.
+ */
+
+unsigned FileName::dirCacheReads;
+unsigned FileName::dirCacheHits;
+
+#if USE_DIR_CACHE
+static StringTable *dirCache;
+
+// Values stored in a directory listing.
+#define DIRENT_FILE     ((void *)1)
+#define DIRENT_DIR      ((void *)2)
+#define DIRENT_UNKNOWN  ((void *)3)     // needs a stat() to tell
+
+static StringTable *readDirCache(const char *dir, size_t dirlen)
+{
+    if (!dirCache)
+    {
+        dirCache = new StringTable();
+        dirCache->_init();
+    }
+
+    StringValue *sv = dirCache->update(dir, dirlen);
+    if (!sv->ptrvalue)
+    {
+        StringTable *listing = new StringTable();
+        listing->_init();
+        sv->ptrvalue = listing;
+        FileName::dirCacheReads++;
+
+        DIR *d = opendir(sv->toDchars());
+        if (!d)
+            return listing;     // an empty listing for a missing directory
+
+        struct dirent *de;
+        while ((de = readdir(d)) != NULL)
+        {
+            void *kind = DIRENT_UNKNOWN;
+#ifdef _DIRENT_HAVE_D_TYPE
+            if (de->d_type == DT_REG)
+                kind = DIRENT_FILE;
+            else if (de->d_type == DT_DIR)
+                kind = DIRENT_DIR;
+#endif
+            listing->update(de->d_name, strlen(de->d_name))->ptrvalue = kind;
+        }
+        closedir(d);
+    }
+    return (StringTable *)sv->ptrvalue;
+}
+#endif
+
+int FileName::existsCached(const char *name)
+{
+#if USE_DIR_CACHE
+    const char *n = FileName::name(name);
+    size_t dirlen = n - name;
+    size_t namelen = strlen(n);
+
+    if (!namelen || !strcmp(n, ".") || !strcmp(n, ".."))
+        return exists(name);
+
+    // Drop the trailing separator, except from the root directory.
+    if (dirlen > 1)
+        dirlen--;
+
+    StringTable *listing = dirlen ? readDirCache(name, dirlen)
+                                  : readDirCache(".", 1);
+    StringValue *sv = listing->lookup(n, namelen);
+    if (!sv)
+    {
+        dirCacheHits++;
+        return 0;
+    }
+
+    if (sv->ptrvalue == DIRENT_UNKNOWN)
+    {
+        // Symbolic link, or the file system did not say; stat it once.
+        int result = exists(name);
+        sv->ptrvalue = (result == 2) ? DIRENT_DIR
+                     : (result == 1) ? DIRENT_FILE : NULL;
+        return result;
+    }
+
+    dirCacheHits++;
+    return (sv->ptrvalue == DIRENT_DIR) ? 2 : (sv->ptrvalue == DIRENT_FILE) ? 1 : 0;
+#else
+    return exists(name);
+#endif
+}
+
 int FileName::ensurePathExists(const char *path)
 {
     //printf("FileName::ensurePathExists(%s)\n", path ? path : "");
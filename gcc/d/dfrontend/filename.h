@@ -49,6 +49,9 @@ struct FileName
     static const char *searchPath(Strings *path, const char *name, int cwd);
     static const char *safeSearchPath(Strings *path, const char *name);
     static int exists(const char *name);
+    static int existsCached(const char *name);
+    static unsigned dirCacheReads;      // directories listed by existsCached
+    static unsigned dirCacheHits;       // exists() calls saved by existsCached
     static int ensurePathExists(const char *path);
     static const char *canonicalName(const char *name);
 
@@ -95,6 +95,8 @@ FuncDeclaration::FuncDeclaration(Loc loc, Loc endloc, Identifier *id, StorageCla
     builtin = BUILTINunknown;
     tookAddressOf = 0;
     requiresClosure = false;
+    scannedDelegates = false;
+    closureReason = NULL;
     flags = 0;
 #endif
     returns = NULL;
@@ -3606,6 +3608,219 @@ bool checkEscapingSiblings(FuncDeclaration *f, FuncDeclaration *outerFunc)
 }
 
 
+/* Format the reason a closure is needed for -fd-vclosure.
+ */
+static const char *closureReasonf(const char *format, ...)
+{
+    OutBuffer buf;
+    va_list ap;
+    va_start(ap, format);
+    buf.vprintf(format, ap);
+    va_end(ap);
+    return buf.extractString();
+}
+
+
+/* A local variable of delegate type initialized with a delegate literal,
+ * together with the number of times it is referenced, and how many of
+ * those references cannot leak the delegate.
+ */
+struct LocalDelegate
+{
+    VarDeclaration *var;
+    FuncDeclaration *literal;
+    size_t uses;
+    size_t calls;
+};
+
+struct LocalDelegates
+{
+    Array<LocalDelegate> vars;
+    bool counting;              // false while looking for the variables
+
+    LocalDelegate *find(Declaration *d)
+    {
+        for (size_t i = 0; i < vars.dim; i++)
+        {
+            if (vars[i]->var == d)
+                return vars[i];
+        }
+        return NULL;
+    }
+};
+
+/* Return the delegate literal a local variable v is constructed from,
+ * or NULL if v is not a plain local delegate variable.
+ */
+static FuncDeclaration *localDelegateLiteral(VarDeclaration *v, Expression *e)
+{
+    if (v->isDataseg() || v->nestedrefs.dim ||
+        (v->storage_class & (STCref | STCout | STClazy | STCparameter)) ||
+        v->type->toBasetype()->ty != Tdelegate)
+        return NULL;
+
+    if (e->op != TOKconstruct && e->op != TOKblit)
+        return NULL;
+    AssignExp *ae = (AssignExp *)e;
+    if (ae->e1->op != TOKvar || ((VarExp *)ae->e1)->var != v)
+        return NULL;
+
+    e = ae->e2;
+    if (e->op == TOKcast)
+        e = ((CastExp *)e)->e1;
+    if (e->op != TOKfunction)
+        return NULL;
+
+    return ((FuncExp *)e)->fd;
+}
+
+static int scanDelegateExp(Expression *e, void *param)
+{
+    LocalDelegates *ld = (LocalDelegates *)param;
+
+    switch (e->op)
+    {
+        case TOKdeclaration:
+        {
+            Dsymbol *s = ((DeclarationExp *)e)->declaration;
+            VarDeclaration *v = s->isVarDeclaration();
+            if (!v)
+            {
+                /* These can only reach the frame through nested functions,
+                 * which are accounted for by nestedrefs.
+                 */
+                return !(s->isFuncDeclaration() || s->isAggregateDeclaration() ||
+                         s->isAliasDeclaration() || s->isEnumDeclaration() ||
+                         s->isTemplateDeclaration() || s->isImport());
+            }
+            if (v->toAlias()->isTupleDeclaration())
+                return 1;
+            if (!v->init || v->init->isVoidInitializer())
+                return 0;
+
+            ExpInitializer *ie = v->init->isExpInitializer();
+            if (!ie)
+                return 1;
+
+            Expression *ex = ie->exp;
+            if (!ld->counting)
+            {
+                FuncDeclaration *fd = localDelegateLiteral(v, ex);
+                if (fd)
+                {
+                    LocalDelegate *d = new LocalDelegate();
+                    d->var = v;
+                    d->literal = fd;
+                    d->uses = 0;
+                    d->calls = 0;
+                    ld->vars.push(d);
+                }
+            }
+            else if (ld->find(v))
+            {
+                // Skip over the construction of v itself.
+                ex = ((AssignExp *)ex)->e2;
+            }
+            return ex->apply(&scanDelegateExp, param);
+        }
+
+        case TOKvar:
+        case TOKsymoff:
+            if (ld->counting)
+            {
+                LocalDelegate *d = ld->find(((SymbolExp *)e)->var);
+                if (d)
+                    d->uses++;
+            }
+            return 0;
+
+        case TOKcall:
+        {
+            if (!ld->counting)
+                return 0;
+
+            CallExp *ce = (CallExp *)e;
+            if (ce->e1->op == TOKvar)
+            {
+                LocalDelegate *d = ld->find(((VarExp *)ce->e1)->var);
+                if (d)
+                    d->calls++;
+            }
+
+            // Passing it to a parameter that doesn't escape is fine too.
+            Type *t = ce->e1->type ? ce->e1->type->toBasetype() : NULL;
+            if (t && (t->ty == Tdelegate || t->ty == Tpointer))
+                t = t->nextOf()->toBasetype();
+            if (!t || t->ty != Tfunction || !ce->arguments)
+                return 0;
+
+            TypeFunction *tf = (TypeFunction *)t;
+            size_t nparams = Parameter::dim(tf->parameters);
+            for (size_t i = 0; i < ce->arguments->dim && i < nparams; i++)
+            {
+                Expression *arg = (*ce->arguments)[i];
+                if (arg->op == TOKcast)
+                    arg = ((CastExp *)arg)->e1;
+                if (arg->op != TOKvar)
+                    continue;
+
+                LocalDelegate *d = ld->find(((VarExp *)arg)->var);
+                if (d && !tf->parameterEscapes(Parameter::getNth(tf->parameters, i)))
+                    d->calls++;
+            }
+            return 0;
+        }
+
+        default:
+            return 0;
+    }
+}
+
+static bool scanDelegateStatement(Statement *s, void *param)
+{
+    return s->applyExps(&scanDelegateExp, param) != 0;
+}
+
+/*******************************
+ * Find the delegate literals assigned to local variables of this
+ * function, where the variable is only ever called, or passed to
+ * parameters that do not escape. The address of such a literal never
+ * leaves the function, so it doesn't force the variables it uses into
+ * a closure. For example, with:
+ *      int x;
+ *      auto dg = () { return x; };
+ *      foo(dg());
+ * x can stay in the stack frame.
+ */
+
+void FuncDeclaration::scanLocalDelegates()
+{
+    if (scannedDelegates)
+        return;
+    scannedDelegates = true;
+
+    if (!fbody || semanticRun < PASSsemantic3done)
+        return;
+
+    LocalDelegates ld;
+    ld.counting = false;
+    if (fbody->apply(&scanDelegateStatement, &ld) || !ld.vars.dim)
+        return;
+
+    ld.counting = true;
+    if (fbody->apply(&scanDelegateStatement, &ld))
+        return;
+
+    for (size_t i = 0; i < ld.vars.dim; i++)
+    {
+        LocalDelegate *d = ld.vars[i];
+        //printf("%s: uses = %d, calls = %d\n", d->var->toChars(), (int)d->uses, (int)d->calls);
+        if (d->uses == d->calls)
+            d->literal->tookAddressOf = 0;
+    }
+}
+
+
 /*******************************
  * Look at all the variables in this function that are referenced
  * by nested functions, and determine if a closure needs to be
@@ -3636,7 +3851,11 @@ bool FuncDeclaration::needsClosure()
     //printf("FuncDeclaration::needsClosure() %s\n", toChars());
 
     if (requiresClosure)
+    {
+        if (!closureReason)
+            closureReason = "a nested function that escapes uses its frame";
         goto Lyes;
+    }
 
     for (size_t i = 0; i < closureVars.dim; i++)
     {   VarDeclaration *v = closureVars[i];
@@ -3647,6 +3866,18 @@ bool FuncDeclaration::needsClosure()
         {   FuncDeclaration *f = v->nestedrefs[j];
             assert(f != this);
 
+            /* Delegate literals that never leave the function they are
+             * declared in don't count as having their address taken.
+             */
+            for (Dsymbol *s = f->parent; s; s = s->parent)
+            {
+                FuncDeclaration *fx = s->isFuncDeclaration();
+                if (fx)
+                    fx->scanLocalDelegates();
+                if (s == this)
+                    break;
+            }
+
             //printf("\t\tf = %s, isVirtual=%d, isThis=%p, tookAddressOf=%d\n", f->toChars(), f->isVirtual(), f->isThis(), f->tookAddressOf);
 
             /* Look to see if f escapes. We consider all parents of f within
@@ -3665,6 +3896,11 @@ bool FuncDeclaration::needsClosure()
                      */
                     markAsNeedingClosure( (fx == f) ? fx->parent : fx, this);
 
+                    if (global.params.vclosure)
+                        closureReason = closureReasonf(fx->isThis()
+                            ? "%s is used by %s, a member of a nested aggregate"
+                            : "%s is used by %s, whose address escapes",
+                            v->toChars(), fx->toPrettyChars());
                     goto Lyes;
                 }
 
@@ -3673,7 +3909,12 @@ bool FuncDeclaration::needsClosure()
                  * to check the callers of our siblings.
                  */
                 if (fx && checkEscapingSiblings(fx, this))
+                {
+                    if (global.params.vclosure)
+                        closureReason = closureReasonf("%s is used by %s, which is called by a nested function whose address escapes",
+                            v->toChars(), fx->toPrettyChars());
                     goto Lyes;
+                }
             }
         }
     }
@@ -3695,6 +3936,9 @@ bool FuncDeclaration::needsClosure()
                 //printf("\t\t\tparent = %s %s\n", s->kind(), s->toChars());
                 if (s == this)
                 {   //printf("\t\treturning local %s\n", st->toChars());
+                    if (global.params.vclosure)
+                        closureReason = closureReasonf("it returns %s, which is nested inside it",
+                            st->toChars());
                     goto Lyes;
                 }
             }
@@ -11,6 +11,7 @@
 #include <stdio.h>
 #include <string.h>
 
+#include "rmem.h"
 #include "root.h"
 #include "identifier.h"
 #include "mars.h"
@@ -77,13 +78,21 @@ int Identifier::dyncast()
     return DYNCAST_IDENTIFIER;
 }
 
+THREAD_LOCAL DeferredIds *Identifier::deferred = NULL;
+
+static size_t generatednum;
+
 // BUG: these are redundant with Lexer::uniqueId()
 
 Identifier *Identifier::generateId(const char *prefix)
 {
-    static size_t i;
-
-    return generateId(prefix, ++i);
+    if (deferred)
+    {   // Numbered by nameGeneratedId() once the module is parsed for real
+        Identifier *id = new Identifier(mem.strdup(prefix), TOKidentifier);
+        deferred->generatedIds.push(id);
+        return id;
+    }
+    return generateId(prefix, ++generatednum);
 }
 
 Identifier *Identifier::generateId(const char *prefix, size_t i)
@@ -96,3 +105,24 @@ Identifier *Identifier::generateId(const char *prefix, size_t i)
     buf.data = NULL;
     return Lexer::idPool(id);
 }
+
+void Identifier::nameGeneratedId(Identifier *id)
+{   OutBuffer buf;
+
+    buf.writestring(id->string);
+    buf.printf("%llu", (ulonglong)++generatednum);
+    Lexer::nameId(id, buf.toChars());
+}
+
+/********************************************
+ * Number the identifiers, in the same order as if the module
+ * hadn't been parsed ahead.
+ */
+
+void DeferredIds::name()
+{
+    for (size_t i = 0; i < uniqueIds.dim; i++)
+        Lexer::nameUniqueId(uniqueIds[i]);
+    for (size_t i = 0; i < generatedIds.dim; i++)
+        Identifier::nameGeneratedId(generatedIds[i]);
+}
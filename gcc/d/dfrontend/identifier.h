@@ -17,6 +17,8 @@
 
 #include "root.h"
 
+struct DeferredIds;
+
 class Identifier : public RootObject
 {
 public:
@@ -34,6 +36,21 @@ public:
 
     static Identifier *generateId(const char *prefix);
     static Identifier *generateId(const char *prefix, size_t i);
+    static void nameGeneratedId(Identifier *id);
+
+    static THREAD_LOCAL DeferredIds *deferred;  // set while parsing ahead
+};
+
+/* A thread parsing a module ahead of time can't number the identifiers
+ * it generates, as that would depend on the order the threads run in.
+ * They are numbered when the module is parsed for real instead.
+ */
+struct DeferredIds
+{
+    Array<Identifier> uniqueIds;        // from Lexer::uniqueId()
+    Array<Identifier> generatedIds;     // from Identifier::generateId()
+
+    void name();
 };
 
 #endif /* DMD_IDENTIFIER_H */
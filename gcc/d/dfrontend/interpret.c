@@ -40,9 +40,6 @@
 #define LOGCOMPILE 0
 #define SHOWPERFORMANCE 0
 
-// Maximum allowable recursive function calls in CTFE
-#define CTFE_RECURSION_LIMIT 1000
-
 /**
   The values of all CTFE variables
 */
@@ -138,8 +135,11 @@ size_t CtfeStack::maxStackUsage()
 void CtfeStack::startFrame(Expression *thisexp)
 {
     size_t oldframe = framepointer;
+    void **olddata = frames.data;
     frames.push((void *)(size_t)(framepointer));
     savedThis.push(localThis);
+    if (frames.data != olddata)
+        mem.pinRegion();    // the stack has grown into the CTFE region
     framepointer = stackPointer();
     localThis = thisexp;
 }
@@ -189,10 +189,13 @@ void CtfeStack::push(VarDeclaration *v)
         values[v->ctfeAdrOnStack] = NULL;
         return;
     }
+    Expression **olddata = values.data;
     savedId.push((void *)(size_t)(v->ctfeAdrOnStack));
     v->ctfeAdrOnStack = values.dim;
     vars.push(v);
     values.push(NULL);
+    if (values.data != olddata)
+        mem.pinRegion();    // the stack has grown into the CTFE region
 }
 
 void CtfeStack::pop(VarDeclaration *v)
@@ -231,6 +234,7 @@ void CtfeStack::saveGlobalConstant(VarDeclaration *v, Expression *e)
 #else
      assert( v->init && v->isConst() && !v->isCTFE());
 #endif
+     mem.pinRegion();
      v->ctfeAdrOnStack = globalValues.dim;
      globalValues.push(e);
 }
@@ -273,18 +277,21 @@ Expression *scrubReturnValue(Loc loc, Expression *e);
 /*************************************
  * CTFE-object code for a single function
  *
- * Currently only counts the number of local variables in the function
+ * Counts the number of local variables in the function, and compiles
+ * it to bytecode if it only works on integral or floating point scalars.
  */
 struct CompiledCtfeFunction
 {
     FuncDeclaration *func; // Function being compiled, NULL if global scope
     int numVars;           // Number of variables declared in this function
     Loc callingloc;
+    CtfeCode *code;        // Bytecode, NULL if none
 
     CompiledCtfeFunction(FuncDeclaration *f)
     {
         func = f;
         numVars = 0;
+        code = NULL;
     }
 
     void onDeclaration(VarDeclaration *v)
@@ -367,7 +374,10 @@ void ExpStatement::ctfeCompile(CompiledCtfeFunction *ccf)
     printf("%s ExpStatement::ctfeCompile\n", loc.toChars());
 #endif
     if (exp)
+    {
         ccf->onExpression(exp);
+        ccf->code->expStatement(exp);
+    }
 }
 
 void CompoundStatement::ctfeCompile(CompiledCtfeFunction *ccf)
@@ -387,6 +397,7 @@ void UnrolledLoopStatement::ctfeCompile(CompiledCtfeFunction *ccf)
 #if LOGCOMPILE
     printf("%s UnrolledLoopStatement::ctfeCompile\n", loc.toChars());
 #endif
+    ccf->code->cantCompile();
     for (size_t i = 0; i < statements->dim; i++)
     {   Statement *s = (*statements)[i];
         if (s)
@@ -401,10 +412,18 @@ void IfStatement::ctfeCompile(CompiledCtfeFunction *ccf)
 #endif
 
     ccf->onExpression(condition);
+    size_t jelse = ccf->code->jumpIfFalse(condition);
     if (ifbody)
         ifbody->ctfeCompile(ccf);
     if (elsebody)
+    {
+        size_t jend = ccf->code->jump();
+        ccf->code->patch(jelse);
         elsebody->ctfeCompile(ccf);
+        ccf->code->patch(jend);
+    }
+    else
+        ccf->code->patch(jelse);
 }
 
 void ScopeStatement::ctfeCompile(CompiledCtfeFunction *ccf)
@@ -431,8 +450,13 @@ void DoStatement::ctfeCompile(CompiledCtfeFunction *ccf)
     printf("%s DoStatement::ctfeCompile\n", loc.toChars());
 #endif
     ccf->onExpression(condition);
+    size_t top = ccf->code->here();
+    ccf->code->beginLoop();
     if (body)
         body->ctfeCompile(ccf);
+    size_t cont = ccf->code->here();
+    ccf->code->patchTo(ccf->code->jumpIfTrue(condition), top);
+    ccf->code->endLoop(cont);
 }
 
 void WhileStatement::ctfeCompile(CompiledCtfeFunction *ccf)
@@ -456,8 +480,19 @@ void ForStatement::ctfeCompile(CompiledCtfeFunction *ccf)
         ccf->onExpression(condition);
     if (increment)
         ccf->onExpression(increment);
+
+    size_t top = ccf->code->here();
+    size_t jend = condition ? ccf->code->jumpIfFalse(condition) : 0;
+    ccf->code->beginLoop();
     if (body)
         body->ctfeCompile(ccf);
+    size_t cont = ccf->code->here();
+    if (increment)
+        ccf->code->expStatement(increment);
+    ccf->code->patchTo(ccf->code->jump(), top);
+    if (condition)
+        ccf->code->patch(jend);
+    ccf->code->endLoop(cont);
 }
 
 void ForeachStatement::ctfeCompile(CompiledCtfeFunction *ccf)
@@ -475,6 +510,7 @@ void SwitchStatement::ctfeCompile(CompiledCtfeFunction *ccf)
 #if LOGCOMPILE
     printf("%s SwitchStatement::ctfeCompile\n", loc.toChars());
 #endif
+    ccf->code->cantCompile();
     ccf->onExpression(condition);
     // Note that the body contains the the Case and Default
     // statements, so we only need to compile the expressions
@@ -509,6 +545,7 @@ void GotoDefaultStatement::ctfeCompile(CompiledCtfeFunction *ccf)
 #if LOGCOMPILE
     printf("%s GotoDefaultStatement::ctfeCompile\n", loc.toChars());
 #endif
+    ccf->code->cantCompile();
 }
 
 void GotoCaseStatement::ctfeCompile(CompiledCtfeFunction *ccf)
@@ -516,6 +553,7 @@ void GotoCaseStatement::ctfeCompile(CompiledCtfeFunction *ccf)
 #if LOGCOMPILE
     printf("%s GotoCaseStatement::ctfeCompile\n", loc.toChars());
 #endif
+    ccf->code->cantCompile();
 }
 
 void SwitchErrorStatement::ctfeCompile(CompiledCtfeFunction *ccf)
@@ -523,6 +561,7 @@ void SwitchErrorStatement::ctfeCompile(CompiledCtfeFunction *ccf)
 #if LOGCOMPILE
     printf("%s SwitchErrorStatement::ctfeCompile\n", loc.toChars());
 #endif
+    ccf->code->cantCompile();
 }
 
 void ReturnStatement::ctfeCompile(CompiledCtfeFunction *ccf)
@@ -532,6 +571,7 @@ void ReturnStatement::ctfeCompile(CompiledCtfeFunction *ccf)
 #endif
     if (exp)
         ccf->onExpression(exp);
+    ccf->code->returnStatement(exp);
 }
 
 void BreakStatement::ctfeCompile(CompiledCtfeFunction *ccf)
@@ -539,6 +579,7 @@ void BreakStatement::ctfeCompile(CompiledCtfeFunction *ccf)
 #if LOGCOMPILE
     printf("%s BreakStatement::ctfeCompile\n", loc.toChars());
 #endif
+    ccf->code->breakStatement(ident);
 }
 
 void ContinueStatement::ctfeCompile(CompiledCtfeFunction *ccf)
@@ -546,6 +587,7 @@ void ContinueStatement::ctfeCompile(CompiledCtfeFunction *ccf)
 #if LOGCOMPILE
     printf("%s ContinueStatement::ctfeCompile\n", loc.toChars());
 #endif
+    ccf->code->continueStatement(ident);
 }
 
 void WithStatement::ctfeCompile(CompiledCtfeFunction *ccf)
@@ -553,6 +595,7 @@ void WithStatement::ctfeCompile(CompiledCtfeFunction *ccf)
 #if LOGCOMPILE
     printf("%s WithStatement::ctfeCompile\n", loc.toChars());
 #endif
+    ccf->code->cantCompile();
     // If it is with(Enum) {...}, just execute the body.
     if (exp->op == TOKimport || exp->op == TOKtype)
     {}
@@ -570,6 +613,7 @@ void TryCatchStatement::ctfeCompile(CompiledCtfeFunction *ccf)
 #if LOGCOMPILE
     printf("%s TryCatchStatement::ctfeCompile\n", loc.toChars());
 #endif
+    ccf->code->cantCompile();
     if (body)
         body->ctfeCompile(ccf);
     for (size_t i = 0; i < catches->dim; i++)
@@ -591,6 +635,7 @@ void TryFinallyStatement::ctfeCompile(CompiledCtfeFunction *ccf)
 #if LOGCOMPILE
     printf("%s TryFinallyStatement::ctfeCompile\n", loc.toChars());
 #endif
+    ccf->code->cantCompile();
     if (body)
         body->ctfeCompile(ccf);
     if (finalbody)
@@ -602,6 +647,7 @@ void ThrowStatement::ctfeCompile(CompiledCtfeFunction *ccf)
 #if LOGCOMPILE
     printf("%s ThrowStatement::ctfeCompile\n", loc.toChars());
 #endif
+    ccf->code->cantCompile();
     ccf->onExpression(exp);
 }
 
@@ -610,6 +656,7 @@ void GotoStatement::ctfeCompile(CompiledCtfeFunction *ccf)
 #if LOGCOMPILE
     printf("%s GotoStatement::ctfeCompile\n", loc.toChars());
 #endif
+    ccf->code->cantCompile();
 }
 
 void LabelStatement::ctfeCompile(CompiledCtfeFunction *ccf)
@@ -617,6 +664,7 @@ void LabelStatement::ctfeCompile(CompiledCtfeFunction *ccf)
 #if LOGCOMPILE
     printf("%s LabelStatement::ctfeCompile\n", loc.toChars());
 #endif
+    ccf->code->cantCompile();
     if (statement)
         statement->ctfeCompile(ccf);
 }
@@ -647,24 +695,27 @@ void AsmStatement::ctfeCompile(CompiledCtfeFunction *ccf)
     printf("%s AsmStatement::ctfeCompile\n", loc.toChars());
 #endif
     // we can't compile asm statements
+    ccf->code->cantCompile();
 }
 
 #ifdef IN_GCC
 // CTFE compile extended asm statement.
 
 void
-ExtAsmStatement::ctfeCompile (CompiledCtfeFunction *)
+ExtAsmStatement::ctfeCompile (CompiledCtfeFunction *ccf)
 {
 #if LOGCOMPILE
     printf("%s ExtAsmStatement::ctfeCompile\n", loc.toChars());
 #endif
     // We can't compile extended asm statements.
+    ccf->code->cantCompile();
 }
 #endif
 
 /*************************************
  * Compile this function for CTFE.
- * At present, this merely allocates variables.
+ * This allocates variables, and builds bytecode for the
+ * function if it only works on integral or floating point scalars.
  */
 void FuncDeclaration::ctfeCompile()
 {
@@ -675,7 +726,9 @@ void FuncDeclaration::ctfeCompile()
     assert(!semantic3Errors);
     assert(semanticRun == PASSsemantic3done);
 
+    mem.pinRegion();
     ctfeCode = new CompiledCtfeFunction(this);
+    ctfeCode->code = CtfeCode::create(this);
     if (parameters)
     {
         Type *tb = type->toBasetype();
@@ -691,6 +744,27 @@ void FuncDeclaration::ctfeCompile()
     if (vresult)
         ctfeCode->onDeclaration(vresult);
     fbody->ctfeCompile(ctfeCode);
+    if (!ctfeCode->code->finish())
+        ctfeCode->code = NULL;
+}
+
+/*************************************
+ * Return the bytecode for fd, compiling it first if need be.
+ * Return NULL if fd has no bytecode, or none yet because it is
+ * still in semantic3.
+ */
+CtfeCode *getCtfeCode(FuncDeclaration *fd)
+{
+    if (!fd->ctfeCode)
+    {
+        if (!fd->fbody || fd->semanticRun == PASSsemantic3)
+            return NULL;
+        if (!fd->functionSemantic3() || fd->semanticRun < PASSsemantic3done)
+            return NULL;
+        fd->ctfeCompile();
+    }
+    CtfeCode *bc = fd->ctfeCode->code;
+    return bc && !bc->failed ? bc : NULL;
 }
 
 /*************************************
@@ -703,6 +777,12 @@ Expression *Expression::ctfeInterpret()
     if (type == Type::terror)
         return this;
 
+    /* Do the evaluation in a memory region of its own, so that all the
+     * intermediate values can be freed afterwards. This isn't possible if
+     * it ran semantic analysis or anything else which holds on to memory.
+     */
+    mem.enterRegion();
+
     // This code is outside a function, but still needs to be compiled
     // (there are compiler-generated temporary variables such as __dollar).
     // However, this will only be run once and can then be discarded.
@@ -713,6 +793,20 @@ Expression *Expression::ctfeInterpret()
     Expression *e = interpret(NULL);
     if (e != EXP_CANT_INTERPRET)
         e = scrubReturnValue(loc, e);
+
+    if (mem.leaveRegion())
+    {
+        Expression *ecopy = e;
+        if (e != EXP_CANT_INTERPRET && e != EXP_VOID_INTERPRET && e != this)
+            ecopy = copyOutOfRegion(e);
+        if (ecopy)
+        {
+            discardAAIndices();
+            mem.releaseRegion();
+            e = ecopy;
+        }
+    }
+
     if (e == EXP_CANT_INTERPRET)
         e = new ErrorExp();
     return e;
@@ -900,6 +994,21 @@ Expression *FuncDeclaration::interpret(InterState *istate, Expressions *argument
         }
     }
 
+    /* Scalar functions run as bytecode; fall back to the
+     * interpreter if anything goes wrong, so it can report it.
+     * While that fallback runs, calls nested in it skip the bytecode:
+     * otherwise each level would rerun the levels below it, only to
+     * bail out again at the same place.
+     */
+    CtfeCode *bc = NULL;
+    if (ctfeCode->code && !thisarg && !ctfeCode->code->fallbacks)
+    {
+        Expression *e = ctfeCode->code->run(loc, &eargs);
+        if (e)
+            return e;
+        bc = ctfeCode->code;
+    }
+
     // Now that we've evaluated all the arguments, we can start the frame
     // (this is the moment when the 'call' actually takes place).
 
@@ -956,6 +1065,8 @@ Expression *FuncDeclaration::interpret(InterState *istate, Expressions *argument
     ++CtfeStatus::callDepth;
     if (CtfeStatus::callDepth > CtfeStatus::maxCallDepth)
         CtfeStatus::maxCallDepth = CtfeStatus::callDepth;
+    if (bc)
+        bc->fallbacks++;
 
     Expression *e = NULL;
     while (1)
@@ -993,6 +1104,8 @@ Expression *FuncDeclaration::interpret(InterState *istate, Expressions *argument
 
     // Leave the function
     --CtfeStatus::callDepth;
+    if (bc)
+        bc->fallbacks--;
 
     ctfeStack.endFrame();
 
@@ -1286,18 +1399,38 @@ Expression *scrubReturnValue(Loc loc, Expression *e)
     }
     if (e->op == TOKstring)
     {
-        ((StringExp *)e)->ownedByCtfe = false;
+        StringExp *se = (StringExp *)e;
+        se->ownedByCtfe = false;
+        if (se->buffer)
+        {   /* Give it its own copy, as a longer string in the same buffer
+             * has overwritten its terminating 0, and the rest of the
+             * compiler expects one.
+             */
+            utf8_t *s = (utf8_t *)mem.calloc(se->len + 1, se->sz);
+            memcpy(s, se->string, se->len * se->sz);
+            se->string = s;
+            se->buffer = NULL;
+        }
     }
     if (e->op == TOKarrayliteral)
     {
-        ((ArrayLiteralExp *)e)->ownedByCtfe = false;
-        if (!scrubArray(loc, ((ArrayLiteralExp *)e)->elements))
+        ArrayLiteralExp *ae = (ArrayLiteralExp *)e;
+        ae->ownedByCtfe = false;
+        if (ae->buffer)
+        {   /* Give it its own copy, as its elements are borrowed from a
+             * buffer which other arrays may share.
+             */
+            ae->elements = (Expressions *)ae->elements->copy();
+            ae->buffer = NULL;
+        }
+        if (!scrubArray(loc, ae->elements))
             return EXP_CANT_INTERPRET;
     }
     if (e->op == TOKassocarrayliteral)
     {
         AssocArrayLiteralExp *aae = (AssocArrayLiteralExp *)e;
         aae->ownedByCtfe = false;
+        discardAAIndex(aae->keys);
         if (!scrubArray(loc, aae->keys))
             return EXP_CANT_INTERPRET;
         if (!scrubArray(loc, aae->values))
@@ -2229,6 +2362,7 @@ Expression *getVarExp(Loc loc, InterState *istate, Declaration *d, CtfeGoal goal
 
         if (!v->originalType && v->scope)   // semantic() not yet run
         {
+            mem.pinRegion();
             v->semantic (v->scope);
             if (v->type->ty == Terror)
                 return EXP_CANT_INTERPRET;
@@ -2241,7 +2375,10 @@ Expression *getVarExp(Loc loc, InterState *istate, Declaration *d, CtfeGoal goal
 #endif
         {
             if(v->scope)
+            {
+                mem.pinRegion();
                 v->init = v->init->semantic(v->scope, v->type, INITinterpret); // might not be run on aggregate members
+            }
             e = v->init->toExpression(v->type);
             if (v->inuse)
             {
@@ -2353,6 +2490,7 @@ Expression *getVarExp(Loc loc, InterState *istate, Declaration *d, CtfeGoal goal
         e = s->dsym->type->defaultInitLiteral(loc);
         if (e->op == TOKerror)
             error(loc, "CTFE failed because of previous errors in %s.init", s->toChars());
+        mem.pinRegion();
         e = e->semantic(NULL);
         if (e->op == TOKerror)
             e = EXP_CANT_INTERPRET;
@@ -2664,26 +2802,24 @@ Expression *AssocArrayLiteralExp::interpret(InterState *istate, CtfeGoal goal)
 
     /* Remove duplicate keys
      */
-    for (size_t i = 1; i < keysx->dim; i++)
-    {
-        Expression *ekey = (*keysx)[i - 1];
-        for (size_t j = i; j < keysx->dim; j++)
+    if (bool *dups = findDuplicateAAKeys(loc, keysx))
+    {
+        if (keysx == keys)
+            keysx = (Expressions *)keys->copy();
+        if (valuesx == values)
+            valuesx = (Expressions *)values->copy();
+        size_t n = 0;
+        for (size_t i = 0; i < keysx->dim; i++)
         {
-            Expression *ekey2 = (*keysx)[j];
-            int eq = ctfeEqual(loc, TOKequal, ekey, ekey2);
-            if (eq)       // if a match
-            {
-                // Remove ekey
-                if (keysx == keys)
-                    keysx = (Expressions *)keys->copy();
-                if (valuesx == values)
-                    valuesx = (Expressions *)values->copy();
-                keysx->remove(i - 1);
-                valuesx->remove(i - 1);
-                i -= 1;         // redo the i'th iteration
-                break;
-            }
+            if (dups[i])
+                continue;
+            (*keysx)[n] = (*keysx)[i];
+            (*valuesx)[n] = (*valuesx)[i];
+            n++;
         }
+        keysx->setDim(n);
+        valuesx->setDim(n);
+        mem.free(dups);
     }
 
     if (keysx != keys || valuesx != values)
@@ -4272,7 +4408,7 @@ Expression *BinAssignExp::interpret(InterState *istate, CtfeGoal goal)
     {
     case TOKaddass:  return interpretAssignCommon(istate, goal, &Add);
     case TOKminass:  return interpretAssignCommon(istate, goal, &Min);
-    case TOKcatass:  return interpretAssignCommon(istate, goal, &ctfeCat);
+    case TOKcatass:  return interpretAssignCommon(istate, goal, &ctfeCatAssign);
     case TOKmulass:  return interpretAssignCommon(istate, goal, &Mul);
     case TOKdivass:  return interpretAssignCommon(istate, goal, &Div);
     case TOKmodass:  return interpretAssignCommon(istate, goal, &Mod);
@@ -5923,6 +6059,8 @@ Expression *RemoveExp::interpret(InterState *istate, CtfeGoal goal)
     }
     valuesx->dim = valuesx->dim - removed;
     keysx->dim = keysx->dim - removed;
+    if (removed)
+        discardAAIndex(keysx);
     return new IntegerExp(loc, removed?1:0, Type::tbool);
 }
 
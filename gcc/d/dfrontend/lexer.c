@@ -91,7 +91,7 @@ void Token::print()
 
 const char *Token::toChars()
 {   const char *p;
-    static char buffer[3 + 3 * sizeof(float80value) + 1];
+    static THREAD_LOCAL char buffer[3 + 3 * sizeof(float80value) + 1];
 
     p = buffer;
     switch (value)
@@ -198,7 +198,7 @@ const char *Token::toChars()
 
 const char *Token::toChars(TOK value)
 {   const char *p;
-    static char buffer[3 + 3 * sizeof(value) + 1];
+    static THREAD_LOCAL char buffer[3 + 3 * sizeof(value) + 1];
 
     p = tochars[value];
     if (!p)
@@ -210,9 +210,14 @@ const char *Token::toChars(TOK value)
 
 /*************************** Lexer ********************************************/
 
-Token *Lexer::freelist = NULL;
+THREAD_LOCAL Token *Lexer::freelist = NULL;
 StringTable Lexer::stringtable;
-OutBuffer Lexer::stringbuffer;
+THREAD_LOCAL StringTable *Lexer::idcache = NULL;
+
+// For __DATE__, __TIME__ and __TIMESTAMP__, set by initKeywords()
+static char date[11+1];
+static char timeofday[8+1];
+static char timestamp[24+1];
 
 Lexer::Lexer(Module *mod,
         utf8_t *base, size_t begoffset, size_t endoffset,
@@ -592,34 +597,12 @@ void Lexer::scan(Token *t)
                     break;
                 }
 
-                StringValue *sv = stringtable.update((char *)t->ptr, p - t->ptr);
-                Identifier *id = (Identifier *) sv->ptrvalue;
-                if (!id)
-                {   id = new Identifier(sv->toDchars(),TOKidentifier);
-                    sv->ptrvalue = (char *)id;
-                }
+                Identifier *id = idPool((char *)t->ptr, p - t->ptr);
                 t->ident = id;
                 t->value = (TOK) id->value;
                 anyToken = 1;
                 if (*t->ptr == '_')     // if special identifier token
                 {
-                    static bool initdone = false;
-                    static char date[11+1];
-                    static char time[8+1];
-                    static char timestamp[24+1];
-
-                    if (!initdone)       // lazy evaluation
-                    {
-                        initdone = true;
-                        time_t t;
-                        ::time(&t);
-                        char *p = ctime(&t);
-                        assert(p);
-                        sprintf(date, "%.6s %.4s", p + 4, p + 20);
-                        sprintf(time, "%.8s", p + 11);
-                        sprintf(timestamp, "%.24s", p);
-                    }
-
 #if DMDV1
                     if (mod && id == Id::FILE)
                     {
@@ -640,7 +623,7 @@ void Lexer::scan(Token *t)
                     }
                     else if (id == Id::TIME)
                     {
-                        t->ustring = (utf8_t *)time;
+                        t->ustring = (utf8_t *)timeofday;
                         goto Lstr;
                     }
                     else if (id == Id::VENDOR)
@@ -2699,7 +2682,22 @@ utf8_t *Lexer::combineComments(utf8_t *c1, utf8_t *c2)
 
 Identifier *Lexer::idPool(const char *s)
 {
-    size_t len = strlen(s);
+    return idPool(s, strlen(s));
+}
+
+Identifier *Lexer::idPool(const char *s, size_t len)
+{
+    StringValue *cv = NULL;
+    if (idcache)
+    {   /* This thread is parsing ahead. Look in its own table first,
+         * so the shared one is only locked the first time.
+         */
+        cv = idcache->update(s, len);
+        if (cv->ptrvalue)
+            return (Identifier *) cv->ptrvalue;
+        lockIdentifiers();
+    }
+
     StringValue *sv = stringtable.update(s, len);
     Identifier *id = (Identifier *) sv->ptrvalue;
     if (!id)
@@ -2707,9 +2705,30 @@ Identifier *Lexer::idPool(const char *s)
         id = new Identifier(sv->toDchars(), TOKidentifier);
         sv->ptrvalue = (char *)id;
     }
+
+    if (cv)
+    {
+        unlockIdentifiers();
+        cv->ptrvalue = (char *)id;
+    }
     return id;
 }
 
+/*********************************************
+ * Give id, made by a thread parsing ahead without going
+ * into the string table, its final name s.
+ */
+
+void Lexer::nameId(Identifier *id, const char *s)
+{
+    size_t len = strlen(s);
+    StringValue *sv = stringtable.update(s, len);
+    if (!sv->ptrvalue)          // unless the source spelled it out itself
+        sv->ptrvalue = (char *)id;
+    id->string = sv->toDchars();
+    id->len = len;
+}
+
 /*********************************************
  * Create a unique identifier using the prefix s.
  */
@@ -2723,10 +2742,25 @@ Identifier *Lexer::uniqueId(const char *s, int num)
     return idPool(buffer);
 }
 
+static int uniquenum;
+
 Identifier *Lexer::uniqueId(const char *s)
 {
-    static int num;
-    return uniqueId(s, ++num);
+    if (Identifier::deferred)
+    {   // Numbered by nameUniqueId() once the module is parsed for real
+        Identifier *id = new Identifier(mem.strdup(s), TOKidentifier);
+        Identifier::deferred->uniqueIds.push(id);
+        return id;
+    }
+    return uniqueId(s, ++uniquenum);
+}
+
+void Lexer::nameUniqueId(Identifier *id)
+{   char buffer[32];
+
+    assert(id->len + sizeof(uniquenum) * 3 + 1 <= sizeof(buffer) / sizeof(buffer[0]));
+    sprintf(buffer, "%s%d", id->string, ++uniquenum);
+    nameId(id, buffer);
 }
 
 /****************************************
@@ -2889,6 +2923,14 @@ void Lexer::initKeywords()
 
     cmtable_init();
 
+    time_t t;
+    ::time(&t);
+    char *p = ctime(&t);
+    assert(p);
+    sprintf(date, "%.6s %.4s", p + 4, p + 20);
+    sprintf(timeofday, "%.8s", p + 11);
+    sprintf(timestamp, "%.24s", p);
+
     for (size_t u = 0; u < nkeywords; u++)
     {
         //printf("keyword[%d] = '%s'\n",u, keywords[u].name);
@@ -267,8 +267,9 @@ class Lexer
 {
 public:
     static StringTable stringtable;
-    static OutBuffer stringbuffer;
-    static Token *freelist;
+    static THREAD_LOCAL StringTable *idcache;   // identifiers found by a thread parsing ahead
+    static THREAD_LOCAL Token *freelist;
+    OutBuffer stringbuffer;
 
     Loc scanloc;                // for error messages
 
@@ -287,6 +288,9 @@ public:
 
     static void initKeywords();
     static Identifier *idPool(const char *s);
+    static Identifier *idPool(const char *s, size_t len);
+    static void nameId(Identifier *id, const char *s);
+    static void nameUniqueId(Identifier *id);
     static Identifier *uniqueId(const char *s);
     static Identifier *uniqueId(const char *s, int num);
 
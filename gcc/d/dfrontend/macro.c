@@ -25,14 +25,10 @@ int isIdStart(utf8_t *p);
 int isIdTail(utf8_t *p);
 int utfStride(utf8_t *p);
 
-utf8_t *memdup(utf8_t *p, size_t len)
-{
-    return (utf8_t *)memcpy(mem.malloc(len), p, len);
-}
-
 Macro::Macro(utf8_t *name, size_t namelen, utf8_t *text, size_t textlen)
 {
     next = NULL;
+    names = NULL;
 
 #if 1
     this->name = name;
@@ -52,41 +48,50 @@ Macro::Macro(utf8_t *name, size_t namelen, utf8_t *text, size_t textlen)
 
 
 Macro *Macro::search(utf8_t *name, size_t namelen)
-{   Macro *table;
-
+{
     //printf("Macro::search(%.*s)\n", namelen, name);
-    for (table = this; table; table = table->next)
-    {
-        if (table->namelen == namelen &&
-            memcmp(table->name, name, namelen) == 0)
-        {
-            //printf("\tfound %d\n", table->textlen);
-            break;
-        }
-    }
+    StringValue *sv = names->lookup((char *)name, namelen);
+    Macro *table = sv ? (Macro *)sv->ptrvalue : NULL;
+    //if (table) printf("\tfound %d\n", table->textlen);
     return table;
 }
 
+/**********************************************************
+ * Define macro name[0..namelen] in the table *ptable.
+ * A macro that is already in the table has its text replaced,
+ * so the last definition of a name is the one that is used.
+ * All the Macros in a table share the one StringTable, so
+ * search() does not need to walk the list.
+ */
+
 Macro *Macro::define(Macro **ptable, utf8_t *name, size_t namelen, utf8_t *text, size_t textlen)
 {
     //printf("Macro::define('%.*s' = '%.*s')\n", namelen, name, textlen, text);
 
-    Macro *table;
+    StringTable *names;
 
     //assert(ptable);
-    for (table = *ptable; table; table = table->next)
+    if (*ptable)
+        names = (*ptable)->names;
+    else
     {
-        if (table->namelen == namelen &&
-            memcmp(table->name, name, namelen) == 0)
-        {
-            table->text = text;
-            table->textlen = textlen;
-            return table;
-        }
+        names = new StringTable();
+        names->_init();
+    }
+
+    StringValue *sv = names->update((char *)name, namelen);
+    Macro *table = (Macro *)sv->ptrvalue;
+    if (table)
+    {
+        table->text = text;
+        table->textlen = textlen;
+        return table;
     }
     table = new Macro(name, namelen, text, textlen);
+    table->names = names;
     table->next = *ptable;
     *ptable = table;
+    sv->ptrvalue = table;
     return table;
 }
 
@@ -245,31 +250,53 @@ void Macro::expand(OutBuffer *buf, size_t start, size_t *pend,
     printf("Buf is: '%.*s'\n", *pend - start, buf->data + start);
 #endif
 
+    size_t end = *pend;
+    assert(start <= end);
+    assert(end <= buf->offset);
+
+    OutBuffer res;
+    res.reserve(end - start);
+    expandText(&res, buf->data + start, end - start, arg, arglen);
+
+    buf->remove(start, end - start);
+    buf->insert(start, res.data, res.offset);
+    *pend = start + res.offset;
+}
+
+/*****************************************************
+ * Expand the macros in p[0..end], appending the result to buf.
+ * Each pass reads its input once and appends its output, rather
+ * than editing the text in place, so expansion is linear in the
+ * size of the result.
+ */
+
+void Macro::expandText(OutBuffer *buf, utf8_t *p, size_t end,
+        utf8_t *arg, size_t arglen)
+{
     static int nest;
     if (nest > 100)             // limit recursive expansion
+    {
+        buf->write(p, end);
         return;
+    }
     nest++;
 
-    size_t end = *pend;
-    assert(start <= end);
-    assert(end <= buf->offset);
-
     /* First pass - replace $0
      */
-    arg = memdup(arg, arglen);
-    for (size_t u = start; u + 1 < end; )
+    OutBuffer tmp;
+    tmp.reserve(end);
+    size_t u = 0;
+    while (u + 1 < end)
     {
-        utf8_t *p = buf->data;   // buf->data is not loop invariant
-
         /* Look for $0, but not $$0, and replace it with arg.
          */
         if (p[u] == '$' && (isdigit(p[u + 1]) || p[u + 1] == '+'))
         {
-            if (u > start && p[u - 1] == '$')
+            if (tmp.offset && tmp.data[tmp.offset - 1] == '$')
             {   // Don't expand $$0, but replace it with $0
-                buf->remove(u - 1, 1);
-                end--;
-                u += 1; // now u is one past the closing '1'
+                tmp.setsize(tmp.offset - 1);
+                tmp.write(p + u, 2);
+                u += 2;
                 continue;
             }
 
@@ -282,53 +309,40 @@ void Macro::expand(OutBuffer *buf, size_t start, size_t *pend,
             if (marglen == 0)
             {   // Just remove macro invocation
                 //printf("Replacing '$%c' with '%.*s'\n", p[u + 1], marglen, marg);
-                buf->remove(u, 2);
-                end -= 2;
             }
             else if (c == '+')
             {
-                // Replace '$+' with 'arg'
+                // Replace '$+' with 'arg', scanning it for further expansion
                 //printf("Replacing '$%c' with '%.*s'\n", p[u + 1], marglen, marg);
-                buf->remove(u, 2);
-                buf->insert(u, marg, marglen);
-                end += marglen - 2;
-
-                // Scan replaced text for further expansion
-                size_t mend = u + marglen;
-                expand(buf, u, &mend, NULL, 0);
-                end += mend - (u + marglen);
-                u = mend;
+                expandText(&tmp, marg, marglen, NULL, 0);
             }
             else
             {
-                // Replace '$1' with '\xFF{arg\xFF}'
+                // Replace '$1' with '\xFF{arg\xFF}', scanning arg for further expansion
                 //printf("Replacing '$%c' with '\xFF{%.*s\xFF}'\n", p[u + 1], marglen, marg);
-                buf->data[u] = 0xFF;
-                buf->data[u + 1] = '{';
-                buf->insert(u + 2, marg, marglen);
-                buf->insert(u + 2 + marglen, "\xFF}", 2);
-                end += -2 + 2 + marglen + 2;
-
-                // Scan replaced text for further expansion
-                size_t mend = u + 2 + marglen;
-                expand(buf, u + 2, &mend, NULL, 0);
-                end += mend - (u + 2 + marglen);
-                u = mend;
+                tmp.writeByte(0xFF);
+                tmp.writeByte('{');
+                expandText(&tmp, marg, marglen, NULL, 0);
+                tmp.writeByte(0xFF);
+                tmp.writeByte('}');
             }
-            //printf("u = %d, end = %d\n", u, end);
-            //printf("#%.*s#\n", end, &buf->data[0]);
+            u += 2;
             continue;
         }
 
+        tmp.writeByte(p[u]);
         u++;
     }
+    tmp.write(p + u, end - u);
 
     /* Second pass - replace other macros
      */
-    for (size_t u = start; u + 4 < end; )
+    size_t start = buf->offset;
+    p = tmp.data;
+    end = tmp.offset;
+    u = 0;
+    while (u + 4 < end)
     {
-        utf8_t *p = buf->data;   // buf->data is not loop invariant
-
         /* A valid start of macro expansion is $(c, where c is
          * an id start character, and not $$(c.
          */
@@ -346,8 +360,7 @@ void Macro::expand(OutBuffer *buf, size_t start, size_t *pend,
              * beginning of macro argument (marg).
              */
             for (v = u + 2; v < end; v+=utfStride(p+v))
-            {   utf8_t c = p[v];
-
+            {
                 if (!isIdTail(p+v))
                 {   // We've gone past the end of the macro name.
                     namelen = v - (u + 2);
@@ -360,27 +373,27 @@ void Macro::expand(OutBuffer *buf, size_t start, size_t *pend,
 
             if (v < end)
             {   // v is on the closing ')'
-                if (u > start && p[u - 1] == '$')
+                if (buf->offset > start && buf->data[buf->offset - 1] == '$')
                 {   // Don't expand $$(NAME), but replace it with $(NAME)
-                    buf->remove(u - 1, 1);
-                    end--;
-                    u = v;      // now u is one past the closing ')'
+                    buf->setsize(buf->offset - 1);
+                    buf->write(p + u, v + 1 - u);
+                    u = v + 1;
                     continue;
                 }
 
                 Macro *m = search(name, namelen);
                 if (m)
                 {
-#if 0
-                    if (m->textlen && m->text[0] == ' ')
-                    {   m->text++;
-                        m->textlen--;
-                    }
-#endif
                     if (m->inuse && marglen == 0)
-                    {   // Remove macro invocation
-                        buf->remove(u, v + 1 - u);
-                        end -= v + 1 - u;
+                    {   // Remove macro invocation, passing over the
+                        // character after it
+                        u = v + 1;
+                        if (u < end)
+                        {
+                            buf->writeByte(p[u]);
+                            u++;
+                        }
+                        continue;
                     }
                     else if (m->inuse && arglen == marglen && memcmp(arg, marg, arglen) == 0)
                     {   // Recursive expansion; just leave in place
@@ -389,62 +402,35 @@ void Macro::expand(OutBuffer *buf, size_t start, size_t *pend,
                     else
                     {
                         //printf("\tmacro '%.*s'(%.*s) = '%.*s'\n", m->namelen, m->name, marglen, marg, m->textlen, m->text);
-#if 1
-                        marg = memdup(marg, marglen);
-                        // Insert replacement text
-                        buf->spread(v + 1, 2 + m->textlen + 2);
-                        buf->data[v + 1] = 0xFF;
-                        buf->data[v + 2] = '{';
-                        memcpy(buf->data + v + 3, m->text, m->textlen);
-                        buf->data[v + 3 + m->textlen] = 0xFF;
-                        buf->data[v + 3 + m->textlen + 1] = '}';
-
-                        end += 2 + m->textlen + 2;
-
-                        // Scan replaced text for further expansion
-                        m->inuse++;
-                        size_t mend = v + 1 + 2+m->textlen+2;
-                        expand(buf, v + 1, &mend, marg, marglen);
-                        end += mend - (v + 1 + 2+m->textlen+2);
-                        m->inuse--;
+                        // Replace the invocation with '\xFF{text\xFF}', and
+                        // scan that for further expansion
+                        OutBuffer text;
+                        text.reserve(2 + m->textlen + 2);
+                        text.writeByte(0xFF);
+                        text.writeByte('{');
+                        text.write(m->text, m->textlen);
+                        text.writeByte(0xFF);
+                        text.writeByte('}');
 
-                        buf->remove(u, v + 1 - u);
-                        end -= v + 1 - u;
-                        u += mend - (v + 1);
-#else
-                        // Insert replacement text
-                        buf->insert(v + 1, m->text, m->textlen);
-                        end += m->textlen;
-
-                        // Scan replaced text for further expansion
                         m->inuse++;
-                        size_t mend = v + 1 + m->textlen;
-                        expand(buf, v + 1, &mend, marg, marglen);
-                        end += mend - (v + 1 + m->textlen);
+                        expandText(buf, text.data, text.offset, marg, marglen);
                         m->inuse--;
 
-                        buf->remove(u, v + 1 - u);
-                        end -= v + 1 - u;
-                        u += mend - (v + 1);
-#endif
-                        mem.free(marg);
-                        //printf("u = %d, end = %d\n", u, end);
-                        //printf("#%.*s#\n", end - u, &buf->data[u]);
+                        u = v + 1;
                         continue;
                     }
                 }
                 else
                 {
                     // Replace $(NAME) with nothing
-                    buf->remove(u, v + 1 - u);
-                    end -= (v + 1 - u);
+                    u = v + 1;
                     continue;
                 }
             }
         }
+        buf->writeByte(p[u]);
         u++;
     }
-    mem.free(arg);
-    *pend = end;
+    buf->write(p + u, end - u);
     nest--;
 }
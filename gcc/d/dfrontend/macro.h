@@ -17,12 +17,14 @@
 #include <ctype.h>
 
 #include "root.h"
+#include "stringtable.h"
 
 
 struct Macro
 {
   private:
     Macro *next;                // next in list
+    StringTable *names;         // maps names to the Macros in this list
 
     utf8_t *name;        // macro name
     size_t namelen;             // length of macro name
@@ -34,6 +36,8 @@ struct Macro
 
     Macro(utf8_t *name, size_t namelen, utf8_t *text, size_t textlen);
     Macro *search(utf8_t *name, size_t namelen);
+    void expandText(OutBuffer *buf, utf8_t *p, size_t end,
+        utf8_t *arg, size_t arglen);
 
   public:
     static Macro *define(Macro **ptable, utf8_t *name, size_t namelen, utf8_t *text, size_t textlen);
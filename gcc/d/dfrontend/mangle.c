@@ -14,6 +14,7 @@
 #include <assert.h>
 
 #include "root.h"
+#include "rmem.h"
 
 #include "init.h"
 #include "declaration.h"
@@ -23,6 +24,8 @@
 #include "template.h"
 #include "id.h"
 #include "module.h"
+#include "enum.h"
+#include "aav.h"
 
 #if CPP_MANGLE
 char *cpp_mangle(Dsymbol *s);
@@ -38,12 +41,360 @@ char *cpp_mangle(Dsymbol *s);
 char *mangle(Declaration *sthis, bool isv)
 {
     OutBuffer buf;
-    char *id;
-    Dsymbol *s;
+    Mangler v(&buf);
 
     //printf("::mangle(%s)\n", sthis->toChars());
-    s = sthis;
-    do
+    v.mangleDecl(sthis, isv);
+    char *id = buf.toChars();
+    buf.data = NULL;
+    return id;
+}
+
+/******************************************************************************
+ * Classes reserved to the compiler are mangled without their parent,
+ * to keep simple names for them.
+ */
+static bool hasReservedMangle(ClassDeclaration *cd)
+{
+    if (cd->ident == Id::Exception)
+        return cd->parent->ident == Id::object;
+
+    return (cd->ident == Id::TypeInfo   ||
+//      cd->ident == Id::Exception ||
+        cd->ident == Id::TypeInfo_Struct   ||
+        cd->ident == Id::TypeInfo_Class    ||
+        cd->ident == Id::TypeInfo_Typedef  ||
+        cd->ident == Id::TypeInfo_Tuple ||
+        cd == ClassDeclaration::object     ||
+        cd == Type::typeinfoclass  ||
+        cd == Module::moduleinfo ||
+        memcmp(cd->ident->toChars(), "TypeInfo_", 9) == 0
+       );
+}
+
+/******************************************************************************
+ * Returns true if Declaration::mangle gives d a "_D" name.
+ */
+static bool hasDMangle(Declaration *d)
+{
+    if (!d->parent || d->parent->isModule() || d->linkage == LINKcpp)
+        return d->linkage == LINKd;
+    return true;
+}
+
+/******************************************************************************
+ * Returns true if the mangled name of d can no longer change.  That is
+ * once the types of d and of its enclosing functions are known, and no
+ * attributes of those functions are still being inferred.
+ */
+static bool isMangleStable(Declaration *d)
+{
+    for (Dsymbol *s = d; s; s = s->parent)
+    {
+        FuncDeclaration *fd = s->isFuncDeclaration();
+        if (s != d && !fd)
+            continue;
+
+        Declaration *sd = (Declaration *)s;
+        if (!sd->type || !sd->type->deco)
+            return false;
+        if (fd && fd->flags & (FUNCFLAGpurityInprocess | FUNCFLAGsafetyInprocess | FUNCFLAGnothrowInprocess))
+            return false;
+        if (fd && !fd->type->nextOf())     // return type not inferred yet
+            return false;
+    }
+    return true;
+}
+
+Mangler::Mangler(OutBuffer *buf)
+{
+    this->buf = buf;
+    this->backrefs = global.params.mangleBackrefs;
+    this->idents = NULL;
+    this->types = NULL;
+}
+
+/******************************************************************************
+ * Return the number of bytes needed for a back reference over distance n.
+ */
+static size_t backrefSize(size_t n)
+{
+    size_t size = 2;
+    while (n >= 26)
+    {
+        n /= 26;
+        size++;
+    }
+    return size;
+}
+
+/******************************************************************************
+ * Write a back reference to the identifier or type written at pos.  This is
+ * 'Q' followed by the distance back to pos in base 26, using upper case
+ * letters for the leading digits and a lower case letter for the last.
+ */
+void Mangler::writeBackref(size_t pos)
+{
+    size_t n = buf->offset - pos;
+    assert(n > 0);
+    buf->writeByte('Q');
+
+    size_t div = 1;
+    while (n / div >= 26)
+        div *= 26;
+    while (div >= 26)
+    {
+        size_t digit = n / div;
+        buf->writeByte('A' + (int)digit);
+        n -= digit * div;
+        div /= 26;
+    }
+    buf->writeByte('a' + (int)n);
+}
+
+void Mangler::mangleIdentifier(Identifier *id)
+{
+    const char *name = id->toChars();
+    size_t len = strlen(name);
+
+    if (backrefs)
+    {
+        Value *pv = _aaGet(&idents, (Key)id);
+        if (*pv)
+        {
+            size_t pos = (size_t)*pv - 1;
+            char tmp[sizeof(len) * 3 + 1];
+            size_t lname = sprintf(tmp, "%u", (unsigned)len) + len;
+            if (backrefSize(buf->offset - pos) < lname)
+            {
+                writeBackref(pos);
+                return;
+            }
+        }
+        else
+            *pv = (Value)(buf->offset + 1);
+    }
+    buf->printf("%u%s", (unsigned)len, name);
+}
+
+/******************************************************************************
+ * Write the mangling of t, the same as t->toDecoBuffer(buf, flag) gives
+ * except for the back references.
+ */
+void Mangler::mangleType(Type *t, int flag)
+{
+    if (!backrefs)
+    {
+        if (flag == 0 && t->deco)
+            buf->writestring(t->deco);
+        else
+            t->toDecoBuffer(buf, flag);
+        return;
+    }
+
+    // Only types written the same as their deco can be referred back to.
+    if (t->deco && (flag == 0 || (flag != 0x100 && flag != t->mod)))
+    {
+        Value *pv = _aaGet(&types, (Key)t->deco);
+        if (!*pv)
+            *pv = (Value)(buf->offset + 1);
+        else if (backrefSize(buf->offset - ((size_t)*pv - 1)) < strlen(t->deco))
+        {
+            writeBackref((size_t)*pv - 1);
+            return;
+        }
+    }
+
+    switch (t->ty)
+    {
+        case Tfunction:
+            mangleFuncType((TypeFunction *)t);
+            break;
+
+        case Tarray:
+        case Tpointer:
+        case Treference:
+        case Tdelegate:
+            t->Type::toDecoBuffer(buf, flag);
+            mangleType(t->nextOf(), (flag & 0x100) ? 0 : t->mod);
+            break;
+
+        case Tsarray:
+        {
+            TypeSArray *tsa = (TypeSArray *)t;
+            t->Type::toDecoBuffer(buf, flag);
+            if (tsa->dim)
+                buf->printf("%llu", tsa->dim->toInteger());
+            if (tsa->next)
+                mangleType(tsa->next, (flag & 0x100) ? flag : t->mod);
+            break;
+        }
+
+        case Taarray:
+            t->Type::toDecoBuffer(buf, flag);
+            mangleType(((TypeAArray *)t)->index);
+            mangleType(t->nextOf(), (flag & 0x100) ? 0 : t->mod);
+            break;
+
+        case Tstruct:
+            t->Type::toDecoBuffer(buf, flag);
+            mangleSymbol(((TypeStruct *)t)->sym, false);
+            break;
+
+        case Tclass:
+            t->Type::toDecoBuffer(buf, flag);
+            mangleSymbol(((TypeClass *)t)->sym, false);
+            break;
+
+        case Tenum:
+            t->Type::toDecoBuffer(buf, flag);
+            mangleSymbol(((TypeEnum *)t)->sym, false);
+            break;
+
+        case Ttypedef:
+            t->Type::toDecoBuffer(buf, flag);
+            mangleSymbol(((TypeTypedef *)t)->sym, false);
+            break;
+
+        default:
+            t->toDecoBuffer(buf, flag);
+            break;
+    }
+}
+
+static int mangleParameterDg(void *ctx, size_t n, Parameter *arg)
+{
+    Mangler *v = (Mangler *)ctx;
+    arg->storageClassToDecoBuffer(v->buf);
+    v->mangleType(arg->type);
+    return 0;
+}
+
+void Mangler::mangleFuncType(TypeFunction *tf)
+{
+    if (!backrefs)
+    {
+        tf->toDecoBuffer(buf, 0);
+        return;
+    }
+
+    if (tf->inuse)
+    {   tf->inuse = 2;              // flag error to caller
+        return;
+    }
+    tf->inuse++;
+    tf->attributesToDecoBuffer(buf);
+    Parameter::foreach(tf->parameters, &mangleParameterDg, this);
+    buf->writeByte('Z' - tf->varargs);
+    if (tf->next)
+        mangleType(tf->next);
+    tf->inuse--;
+}
+
+/******************************************************************************
+ * Write the mangling of s->mangle(isv) without its "_D" prefix.
+ */
+void Mangler::mangleSymbol(Dsymbol *s, bool isv)
+{
+    if (TemplateInstance *ti = s->isTemplateInstance())
+    {
+        // TemplateInstance::mangle
+        ti->getIdent();
+        if (!ti->tempdecl || !ti->ident)
+        {
+            manglePlain(ti->mangle(isv));
+            return;
+        }
+        Dsymbol *par = ti->enclosing || ti->isTemplateMixin() ? ti->parent : ti->tempdecl->parent;
+        if (par)
+            mangleSymbol(par, isv);
+        mangleIdentifier(ti->ident);
+    }
+    else if (FuncDeclaration *fd = s->isFuncDeclaration())
+    {
+        // FuncDeclaration::mangle
+        if (fd->isFuncAliasDeclaration())
+            manglePlain(fd->mangle(isv));
+        else if (fd->isUnique())
+            mangleExact(fd, isv);
+        else
+            mangleDsymbol(fd, isv);
+    }
+    else if (AggregateDeclaration *ad = s->isAggregateDeclaration())
+    {
+        // ClassDeclaration::mangle and AggregateDeclaration::mangle
+        ClassDeclaration *cd = ad->isClassDeclaration();
+        Dsymbol *parentsave = ad->parent;
+        if (cd && hasReservedMangle(cd))
+            ad->parent = NULL;
+
+        if (Dsymbol *p = ad->toParent2())
+        {   if (FuncDeclaration *fd = p->isFuncDeclaration())
+                isv = fd->inferRetType || getFuncTemplateDecl(fd);
+        }
+        mangleDsymbol(ad, isv);
+        ad->parent = parentsave;
+    }
+    else if (s->isDeclaration())
+        manglePlain(s->mangle(isv));
+    else
+        mangleDsymbol(s, isv);
+}
+
+/******************************************************************************
+ * Dsymbol::mangle
+ */
+void Mangler::mangleDsymbol(Dsymbol *s, bool isv)
+{
+    if (s->parent)
+    {
+        FuncDeclaration *f = s->parent->isFuncDeclaration();
+        if (f)
+            mangleExact(f, isv);
+        else
+            mangleSymbol(s->parent, isv);
+    }
+    if (s->ident)
+        mangleIdentifier(s->ident);
+    else
+    {
+        const char *id = s->toChars();
+        buf->printf("%llu%s", (ulonglong)strlen(id), id);
+    }
+}
+
+/******************************************************************************
+ * FuncDeclaration::mangleExact
+ */
+void Mangler::mangleExact(FuncDeclaration *fd, bool isv)
+{
+    if (fd->isFuncAliasDeclaration() || fd->mangleOverride || fd->isMain() ||
+        fd->isWinMain() || fd->isDllMain() || fd->ident == Id::tls_get_addr ||
+        !hasDMangle(fd))
+    {
+        manglePlain(fd->mangleExact(isv));
+        return;
+    }
+    mangleDecl(fd, isv);
+}
+
+void Mangler::manglePlain(const char *p)
+{
+    if (p[0] == '_' && p[1] == 'D')
+        p += 2;
+    buf->writestring(p);
+}
+
+/******************************************************************************
+ * Write the mangling of sthis without the "_D" prefix.  The names of the
+ * enclosing scopes are written outermost first.
+ */
+void Mangler::mangleDecl(Declaration *sthis, bool isv)
+{
+    Dsymbols scopes;
+    FuncDeclaration *fparent = NULL;
+
+    for (Dsymbol *s = sthis; s; s = s->parent)
     {
         //printf("mangle: s = %p, '%s', parent = %p\n", s, s->toChars(), s->parent);
         if (s->getIdent())
@@ -51,32 +402,29 @@ char *mangle(Declaration *sthis, bool isv)
             FuncDeclaration *fd = s->isFuncDeclaration();
             if (s != sthis && fd)
             {
-                id = mangle(fd, isv);
-                buf.prependstring(id);
-                goto L1;
-            }
-            else
-            {
-                id = s->ident->toChars();
-                size_t len = strlen(id);
-                char tmp[sizeof(len) * 3 + 1];
-                buf.prependstring(id);
-                sprintf(tmp, "%d", (int)len);
-                buf.prependstring(tmp);
+                fparent = fd;
+                break;
             }
         }
+        scopes.push(s);
+    }
+
+    if (fparent)
+        mangleDecl(fparent, isv);
+    for (size_t i = scopes.dim; i-- > 0; )
+    {
+        Dsymbol *s = scopes[i];
+        if (s->getIdent())
+            mangleIdentifier(s->ident);
         else
-            buf.prependstring("0");
-        s = s->parent;
-    } while (s);
+            buf->writeByte('0');
+    }
 
-//    buf.prependstring("_D");
-L1:
     //printf("deco = '%s'\n", sthis->type->deco ? sthis->type->deco : "null");
     //printf("sthis->type = %s\n", sthis->type->toChars());
     FuncDeclaration *fd = sthis->isFuncDeclaration();
     if (fd && (fd->needThis() || fd->isNested()))
-        buf.writeByte(Type::needThisPrefix());
+        buf->writeByte(Type::needThisPrefix());
     if (isv && fd && (fd->inferRetType || getFuncTemplateDecl(fd)))
     {
 #if DDMD
@@ -88,7 +436,7 @@ L1:
         tfn->isref       = fd->storage_class & STCauto ? false : tfo->isref;
         tfn->trust       = tfo->trust;
         tfn->next        = NULL;     // do not mangle return type
-        tfn->toDecoBuffer(&buf, 0);
+        mangleFuncType(tfn);
 #else
         TypeFunction tfn = *(TypeFunction *)sthis->type;
         TypeFunction *tfo = (TypeFunction *)sthis->originalType;
@@ -98,11 +446,18 @@ L1:
         tfn.isref       = fd->storage_class & STCauto ? false : tfo->isref;
         tfn.trust       = tfo->trust;
         tfn.next        = NULL;     // do not mangle return type
-        tfn.toDecoBuffer(&buf, 0);
+        mangleFuncType(&tfn);
 #endif
     }
     else if (sthis->type->deco)
-        buf.writestring(sthis->type->deco);
+    {
+        // The type of a function is not referred back to, so that
+        // demanglers can always find the parameters of a parent.
+        if (backrefs && fd && sthis->type->ty == Tfunction)
+            mangleFuncType((TypeFunction *)sthis->type);
+        else
+            mangleType(sthis->type);
+    }
     else
     {
 #ifdef DEBUG
@@ -111,10 +466,6 @@ L1:
 #endif
         assert(fd && fd->inferRetType);
     }
-
-    id = buf.toChars();
-    buf.data = NULL;
-    return id;
 }
 
 const char *Declaration::mangle(bool isv)
@@ -166,10 +517,19 @@ const char *Declaration::mangle(bool isv)
                     assert(0);
             }
         }
+        if (!isv && mangleString)
+            return mangleString;
+
         char *p = ::mangle(this, isv);
         OutBuffer buf;
         buf.writestring("_D");
         buf.writestring(p);
+        mem.free(p);
+        if (!isv && isMangleStable(this))
+        {
+            mangleString = internString((char *)buf.data, buf.offset);
+            return mangleString;
+        }
         p = buf.toChars();
         buf.data = NULL;
         //printf("Declaration::mangle(this = %p, '%s', parent = '%s', linkage = %d) = %s\n", this, toChars(), parent ? parent->toChars() : "null", linkage, p);
@@ -295,21 +655,7 @@ const char *ClassDeclaration::mangle(bool isv)
     /* These are reserved to the compiler, so keep simple
      * names for them.
      */
-    if (ident == Id::Exception)
-    {   if (parent->ident == Id::object)
-            parent = NULL;
-    }
-    else if (ident == Id::TypeInfo   ||
-//      ident == Id::Exception ||
-        ident == Id::TypeInfo_Struct   ||
-        ident == Id::TypeInfo_Class    ||
-        ident == Id::TypeInfo_Typedef  ||
-        ident == Id::TypeInfo_Tuple ||
-        this == object     ||
-        this == Type::typeinfoclass  ||
-        this == Module::moduleinfo ||
-        memcmp(ident->toChars(), "TypeInfo_", 9) == 0
-       )
+    if (hasReservedMangle(this))
         parent = NULL;
 
     const char *id = AggregateDeclaration::mangle(isv);
@@ -136,6 +136,7 @@ struct Param
     char quiet;         // suppress non-error messages
     char verbose;       // verbose compile
     char vtls;          // identify thread local variables
+    char vclosure;      // identify closures allocated on the heap
     char vfield;        // identify non-mutable field variables
     char symdebug;      // insert debug symbolic information
     bool alwaysframe;   // always emit standard stack frame
@@ -179,6 +180,7 @@ struct Param
     char betterC;       // be a "better C" compiler; no dependency on D runtime
     bool addMain;       // add a default main() function
     bool allInst;       // generate code for all template instantiations
+    bool mangleBackrefs; // compress mangled names with back references
 
     char *argv0;        // program name
     Strings *imppath;     // array of char*'s of where to look for import modules
@@ -451,6 +453,10 @@ void readFile(Loc loc, File *f);
 void writeFile(Loc loc, File *f);
 void ensurePathToNameExists(Loc loc, const char *name);
 
+// Guard Lexer::stringtable while modules are parsed ahead on other threads
+void lockIdentifiers();
+void unlockIdentifiers();
+
 const char *importHint(const char *s);
 /// Little helper function for writting out deps.
 void escapePath(OutBuffer *buf, const char *fname);
@@ -20,8 +20,11 @@
 #include "id.h"
 #include "import.h"
 #include "dsymbol.h"
+#include "aggregate.h"
 #include "hdrgen.h"
 #include "lexer.h"
+#include "attrib.h"
+#include "rmem.h"
 
 #ifdef IN_GCC
 #include "d-dmd-gcc.h"
@@ -39,6 +42,29 @@ unsigned Module::dprogress;
 
 const char *lookForSourceFile(const char *filename);
 
+THREAD_LOCAL Module *Module::parsingAhead = NULL;
+
+// Modules being parsed ahead, by source file name
+static StringTable *aheadtable;
+
+// Root modules parsed ahead, by module name
+static StringTable *aheadroots;
+
+static const char *aheadName(Identifiers *packages, Identifier *ident)
+{
+    OutBuffer buf;
+    if (packages)
+    {
+        for (size_t i = 0; i < packages->dim; i++)
+        {
+            buf.writestring((*packages)[i]->toChars());
+            buf.writeByte('.');
+        }
+    }
+    buf.writestring(ident->toChars());
+    return buf.extractString();
+}
+
 void Module::init()
 {
     modules = new DsymbolTable();
@@ -86,12 +112,19 @@ Module::Module(char *filename, Identifier *ident, int doDocComment, int doHdrGen
     escapetable = NULL;
     safe = FALSE;
     doppelganger = 0;
+    importsRoot = false;
     cov = NULL;
     covb = NULL;
 
     nameoffset = 0;
     namelen = 0;
 
+    deferredIds = NULL;
+#if MODULEINFO_IS_STRUCT
+    aheadModuleInfo = NULL;
+#endif
+    aheadFailed = false;
+
     srcfilename = FileName::defaultExt(filename, global.mars_ext);
     if (!FileName::equalsExt(srcfilename, global.mars_ext) &&
         !FileName::equalsExt(srcfilename, global.hdr_ext) &&
@@ -181,17 +214,16 @@ const char *Module::kind()
     return "module";
 }
 
-Module *Module::load(Loc loc, Identifiers *packages, Identifier *ident)
-{   Module *m;
-    char *filename;
-
-    //printf("Module::load(ident = '%s')\n", ident->toChars());
+/*********************************************
+ * Build module filename by turning:
+ *  foo.bar.baz
+ * into:
+ *  foo\bar\baz
+ */
 
-    // Build module filename by turning:
-    //  foo.bar.baz
-    // into:
-    //  foo\bar\baz
-    filename = ident->toChars();
+static char *moduleFileName(Identifiers *packages, Identifier *ident)
+{
+    char *filename = ident->toChars();
     if (packages && packages->dim)
     {
         OutBuffer buf;
@@ -210,15 +242,37 @@ Module *Module::load(Loc loc, Identifiers *packages, Identifier *ident)
         buf.writeByte(0);
         filename = (char *)buf.extractData();
     }
+    return filename;
+}
 
-    m = new Module(filename, ident, 0, 0);
-    m->loc = loc;
+Module *Module::load(Loc loc, Identifiers *packages, Identifier *ident)
+{   Module *m = NULL;
+
+    //printf("Module::load(ident = '%s')\n", ident->toChars());
+
+    char *filename = moduleFileName(packages, ident);
 
     /* Look for the source file
      */
     const char *result = lookForSourceFile(filename);
-    if (result)
-        m->srcfile = new File(result);
+
+    if (result && aheadtable)
+    {   // Take it over if it was parsed ahead under the same name
+        StringValue *sv = aheadtable->lookup(result, strlen(result));
+        Module *ma = sv ? (Module *)sv->ptrvalue : NULL;
+        if (ma && ma->ident == ident && strcmp(ma->arg, filename) == 0 && !ma->isRoot())
+        {
+            sv->ptrvalue = NULL;
+            m = ma;
+        }
+    }
+    if (!m)
+    {
+        m = new Module(filename, ident, 0, 0);
+        if (result)
+            m->srcfile = new File(result);
+    }
+    m->loc = loc;
 
     if (global.params.verbose)
     {
@@ -233,7 +287,8 @@ Module *Module::load(Loc loc, Identifiers *packages, Identifier *ident)
         fprintf(global.stdmsg, "%s\t(%s)\n", ident->toChars(), m->srcfile->toChars());
     }
 
-    if (!m->read(loc))
+    // Unless already read while parsing ahead
+    if (!m->srcfile->buffer && !m->read(loc))
         return NULL;
 
     m->parse();
@@ -245,6 +300,158 @@ Module *Module::load(Loc loc, Identifiers *packages, Identifier *ident)
     return m;
 }
 
+/*************************************
+ * Make the module which load() will want for an import, so that it can be
+ * parsed ahead. Returns NULL if there is no source file, or if its
+ * source is already being parsed ahead.
+ */
+
+Module *Module::loadAhead(Identifiers *packages, Identifier *ident)
+{
+    if (aheadroots)
+    {   // Import resolves to the root module of that name, not to a file
+        const char *name = aheadName(packages, ident);
+        if (aheadroots->lookup(name, strlen(name)))
+            return NULL;
+    }
+
+    char *filename = moduleFileName(packages, ident);
+    const char *result = lookForSourceFile(filename);
+    if (!result)
+        return NULL;            // load() reports it
+
+    if (aheadtable && aheadtable->lookup(result, strlen(result)))
+        return NULL;
+
+    Module *m = new Module(filename, ident, 0, 0);
+    m->srcfile = new File(result);
+    m->markAhead();
+    return m;
+}
+
+void Module::markAhead()
+{
+    if (!aheadtable)
+    {
+        aheadtable = new StringTable();
+        aheadtable->_init();
+    }
+    const char *name = srcfile->toChars();
+    aheadtable->update(name, strlen(name))->ptrvalue = (char *)this;
+}
+
+/*************************************
+ * Record the name of this root module, once it has been parsed ahead, so
+ * that loadAhead() leaves imports of it alone. Returns false if it wasn't
+ * parsed ahead, and so its name isn't known yet.
+ */
+
+bool Module::rootAhead()
+{
+    if (!deferredIds)
+        return false;
+    if (!aheadroots)
+    {
+        aheadroots = new StringTable();
+        aheadroots->_init();
+    }
+    const char *name = md ? aheadName(md->packages, md->id) : aheadName(NULL, ident);
+    aheadroots->update(name, strlen(name));
+    return true;
+}
+
+/*************************************
+ * Parse the module on a worker thread, before parse() is called for it.
+ * Only plain UTF-8 source is taken, as the other encodings can give errors
+ * before the parser runs. Anything diagnosed is left for parse() to do
+ * again on the main thread, so that the messages come out in order.
+ * Returns true if members have been parsed.
+ */
+
+bool Module::parseAhead()
+{
+    if (!srcfile->buffer && srcfile->read())
+        return false;           // load() reports it
+
+    utf8_t *buf = srcfile->buffer;
+    size_t buflen = srcfile->len;
+
+    // What parse() takes to be UTF-8
+    if (buflen >= 3 && buf[0] == 0xEF && buf[1] == 0xBB && buf[2] == 0xBF)
+    {
+        buf += 3;
+        buflen -= 3;
+    }
+    else if (buflen >= 2 && (buf[0] == 0 || buf[1] == 0 || buf[0] >= 0x80))
+        return false;
+    if (buflen >= 4 && memcmp(buf, "Ddoc", 4) == 0)
+        return false;
+
+    if (!Lexer::idcache)
+    {
+        Lexer::idcache = new StringTable();
+        Lexer::idcache->_init();
+    }
+    DeferredIds *ids = new DeferredIds();
+    Identifier::deferred = ids;
+    parsingAhead = this;
+    aheadFailed = false;
+
+    Parser p(this, buf, buflen, docfile != NULL);
+    p.nextToken();
+    members = p.parseModule();
+    md = p.md;
+    numlines = p.scanloc.linnum;
+
+    parsingAhead = NULL;
+    Identifier::deferred = NULL;
+    if (aheadFailed)
+    {
+        members = NULL;
+        md = NULL;
+        numlines = 0;
+        aheadClasses.setDim(0);
+#if MODULEINFO_IS_STRUCT
+        aheadModuleInfo = NULL;
+#endif
+        return false;
+    }
+    deferredIds = ids;
+    return true;
+}
+
+/*************************************
+ * Append to todo the modules imported by declarations in members,
+ * which are to be parsed ahead too. Only the imports which are sure to be
+ * loaded are taken, so none under a conditional declaration.
+ */
+
+static void importsAhead(Dsymbols *members, Modules *todo)
+{
+    if (!members)
+        return;
+    for (size_t i = 0; i < members->dim; i++)
+    {
+        Dsymbol *s = (*members)[i];
+        Import *imp = s->isImport();
+        if (imp)
+        {
+            Module *m = Module::loadAhead(imp->packages, imp->id);
+            if (m)
+                todo->push(m);
+            continue;
+        }
+        AttribDeclaration *ad = s->isAttribDeclaration();
+        if (ad && !ad->isConditionalDeclaration())
+            importsAhead(ad->decl, todo);
+    }
+}
+
+void Module::importsAhead(Modules *todo)
+{
+    ::importsAhead(members, todo);
+}
+
 bool Module::read(Loc loc)
 {
     //printf("Module::read('%s') file '%s'\n", toChars(), srcfile->toChars());
@@ -314,13 +521,13 @@ inline unsigned readlongBE(unsigned *p)
         (((unsigned char *)p)[0] << 24);
 }
 
-void Module::parse()
-{
-    //printf("Module::parse()\n");
-
-    char *srcname = srcfile->name->toChars();
-    //printf("Module::parse(srcname = '%s')\n", srcname);
+/*************************************
+ * Decode the source into UTF-8 and parse it.
+ * Returns false if it is a Ddoc file, which has nothing to parse.
+ */
 
+bool Module::parseSource()
+{
     utf8_t *buf = srcfile->buffer;
     size_t buflen = srcfile->len;
 
@@ -494,20 +701,50 @@ void Module::parse()
         isDocFile = 1;
         if (!docfile)
             setDocfile();
-        return;
+        return false;
     }
     Parser p(this, buf, buflen, docfile != NULL);
     p.nextToken();
     members = p.parseModule();
 
+    md = p.md;
+    numlines = p.scanloc.linnum;
+    return true;
+}
+
+void Module::parse()
+{
+    //printf("Module::parse()\n");
+
+    char *srcname = srcfile->name->toChars();
+    //printf("Module::parse(srcname = '%s')\n", srcname);
+
+    if (deferredIds)
+    {   /* Parsed ahead already. Number the identifiers generated then
+         * in the order they would have been otherwise.
+         */
+        deferredIds->name();
+        deferredIds = NULL;
+
+        // Which the parser would have done for these
+        bool inObject = md && !md->packages && md->id == Id::object;
+        for (size_t i = 0; i < aheadClasses.dim; i++)
+            aheadClasses[i]->checkSpecialName(inObject);
+        aheadClasses.setDim(0);
+#if MODULEINFO_IS_STRUCT
+        if (aheadModuleInfo)
+            aheadModuleInfo->setModuleInfo();
+        aheadModuleInfo = NULL;
+#endif
+    }
+    else if (!parseSource())
+        return;
+
     if (srcfile->ref == 0)
-        ::free(srcfile->buffer);
+        mem.free(srcfile->buffer);
     srcfile->buffer = NULL;
     srcfile->len = 0;
 
-    md = p.md;
-    numlines = p.scanloc.linnum;
-
     /* The symbol table into which the module is to be inserted.
      */
     DsymbolTable *dst;
@@ -870,7 +1107,10 @@ Dsymbol *Module::search(Loc loc, Identifier *ident, int flags)
     //printf("%s Module::search('%s', flags = %d) insearch = %d\n", toChars(), ident->toChars(), flags, insearch);
     Dsymbol *s;
     if (insearch)
+    {
         s = NULL;
+        searchCutoffs++;
+    }
     else
     {
         insearch = 1;
@@ -1165,7 +1405,8 @@ Dsymbol *Package::search(Loc loc, Identifier *ident, int flags)
 /********************************************
  * Look for the source file if it's different from filename.
  * Look for .di, .d, directory, and along global.path.
- * Does not open the file.
+ * Does not open the file.  Directory listings are cached, so the
+ * same import path is only read once per compilation.
  * Input:
  *      filename        as supplied by the user
  *      global.path
@@ -1180,21 +1421,21 @@ const char *lookForSourceFile(const char *filename)
      */
 
     const char *sdi = FileName::forceExt(filename, global.hdr_ext);
-    if (FileName::exists(sdi) == 1)
+    if (FileName::existsCached(sdi) == 1)
         return sdi;
 
     const char *sd  = FileName::forceExt(filename, global.mars_ext);
-    if (FileName::exists(sd) == 1)
+    if (FileName::existsCached(sd) == 1)
         return sd;
 
-    if (FileName::exists(filename) == 2)
+    if (FileName::existsCached(filename) == 2)
     {
         /* The filename exists and it's a directory.
          * Therefore, the result should be: filename/package.d
          * iff filename/package.d is a file
          */
         const char *n = FileName::combine(filename, "package.d");
-        if (FileName::exists(n) == 1)
+        if (FileName::existsCached(n) == 1)
             return n;
         FileName::free(n);
     }
@@ -1210,22 +1451,22 @@ const char *lookForSourceFile(const char *filename)
         const char *p = (*global.path)[i];
 
         const char *n = FileName::combine(p, sdi);
-        if (FileName::exists(n) == 1)
+        if (FileName::existsCached(n) == 1)
             return n;
         FileName::free(n);
 
         n = FileName::combine(p, sd);
-        if (FileName::exists(n) == 1)
+        if (FileName::existsCached(n) == 1)
             return n;
         FileName::free(n);
 
         const char *b = FileName::removeExt(filename);
         n = FileName::combine(p, b);
         FileName::free(b);
-        if (FileName::exists(n) == 2)
+        if (FileName::existsCached(n) == 2)
         {
             const char *n2 = FileName::combine(n, "package.d");
-            if (FileName::exists(n2) == 1)
+            if (FileName::existsCached(n2) == 1)
                 return n2;
             FileName::free(n2);
         }
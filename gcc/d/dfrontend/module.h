@@ -20,6 +20,7 @@
 
 class ClassDeclaration;
 struct ModuleDeclaration;
+struct DeferredIds;
 struct Macro;
 struct Escape;
 class VarDeclaration;
@@ -110,10 +111,19 @@ public:
     size_t nameoffset;          // offset of module name from start of ModuleInfo
     size_t namelen;             // length of module name in characters
 
+    DeferredIds *deferredIds;   // if parsed ahead, the identifiers still to number
+    ClassDeclarations aheadClasses;     // if parsed ahead, the classes to check for special names
+#if MODULEINFO_IS_STRUCT
+    StructDeclaration *aheadModuleInfo; // if parsed ahead, the ModuleInfo struct it declares
+#endif
+    bool aheadFailed;           // diagnostics while parsing ahead
+    static THREAD_LOCAL Module *parsingAhead;   // module being parsed ahead by this thread
+
     Module(char *arg, Identifier *ident, int doDocComment, int doHdrGen);
     ~Module();
 
     static Module *load(Loc loc, Identifiers *packages, Identifier *ident);
+    static Module *loadAhead(Identifiers *packages, Identifier *ident);
 
     void toCBuffer(OutBuffer *buf, HdrGenState *hgs);
     void toJson(JsonOut *json);
@@ -123,6 +133,11 @@ public:
     void setDocfile();
     bool read(Loc loc); // read file, returns 'true' if succeed, 'false' otherwise.
     void parse();       // syntactic parse
+    bool parseSource();
+    void markAhead();   // source file is being parsed ahead
+    bool rootAhead();   // root module parsed ahead, not to be parsed again as an import
+    bool parseAhead();  // parse on a worker thread, before parse()
+    void importsAhead(Modules *todo);   // imported modules to parse ahead
     void importAll(Scope *sc);
     void semantic();    // semantic analysis
     void semantic2();   // pass 2 semantic analysis
@@ -148,6 +163,7 @@ public:
     // Back end
 
     int doppelganger;           // sub-module
+    bool importsRoot;           // true if a root module is transitively imported
     Symbol *cov;                // private uint[] __coverage;
     unsigned *covb;             // bit array of valid code line numbers
 
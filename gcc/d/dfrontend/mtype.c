@@ -133,6 +133,7 @@ StringTable Type::stringtable;
 
 Type::Type(TY ty)
 {
+    mem.pinRegion();    // types get cached in other types
     this->ty = ty;
     this->mod = 0;
     this->deco = NULL;
@@ -5368,8 +5369,7 @@ Lnotcovariant:
 }
 
 void TypeFunction::toDecoBuffer(OutBuffer *buf, int flag)
-{   unsigned char mc;
-
+{
     //printf("TypeFunction::toDecoBuffer() this = %p %s\n", this, toChars());
     //static int nest; if (++nest == 50) *(char*)0=0;
     if (inuse)
@@ -5377,6 +5377,24 @@ void TypeFunction::toDecoBuffer(OutBuffer *buf, int flag)
         return;
     }
     inuse++;
+    attributesToDecoBuffer(buf);
+    // Write argument types
+    Parameter::argsToDecoBuffer(buf, parameters);
+    //if (buf->data[buf->offset - 1] == '@') halt();
+    buf->writeByte('Z' - varargs);      // mark end of arg list
+    if(next != NULL)
+        next->toDecoBuffer(buf);
+    inuse--;
+}
+
+/********************************
+ * Write the modifiers, calling convention and attributes
+ * that start the mangling of a function type.
+ */
+
+void TypeFunction::attributesToDecoBuffer(OutBuffer *buf)
+{   unsigned char mc;
+
     MODtoDecoBuffer(buf, mod);
     switch (linkage)
     {
@@ -5410,13 +5428,6 @@ void TypeFunction::toDecoBuffer(OutBuffer *buf, int flag)
             default: break;
         }
     }
-    // Write argument types
-    Parameter::argsToDecoBuffer(buf, parameters);
-    //if (buf->data[buf->offset - 1] == '@') halt();
-    buf->writeByte('Z' - varargs);      // mark end of arg list
-    if(next != NULL)
-        next->toDecoBuffer(buf);
-    inuse--;
 }
 
 void TypeFunction::toCBuffer(OutBuffer *buf, Identifier *ident, HdrGenState *hgs)
@@ -9651,6 +9662,20 @@ Type *Parameter::isLazyArray()
 }
 
 void Parameter::toDecoBuffer(OutBuffer *buf)
+{
+    storageClassToDecoBuffer(buf);
+#if 0
+    int mod = 0x100;
+    if (type->toBasetype()->ty == Tclass)
+        mod = 0;
+    type->toDecoBuffer(buf, mod);
+#else
+    //type->toHeadMutable()->toDecoBuffer(buf, 0);
+    type->toDecoBuffer(buf, 0);
+#endif
+}
+
+void Parameter::storageClassToDecoBuffer(OutBuffer *buf)
 {
     if (storageClass & STCscope)
         buf->writeByte('M');
@@ -9674,15 +9699,6 @@ void Parameter::toDecoBuffer(OutBuffer *buf)
 #endif
             assert(0);
     }
-#if 0
-    int mod = 0x100;
-    if (type->toBasetype()->ty == Tclass)
-        mod = 0;
-    type->toDecoBuffer(buf, mod);
-#else
-    //type->toHeadMutable()->toDecoBuffer(buf, 0);
-    type->toDecoBuffer(buf, 0);
-#endif
 }
 
 /***************************************
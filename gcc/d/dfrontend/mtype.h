@@ -678,6 +678,7 @@ public:
     Type *semantic(Loc loc, Scope *sc);
     void purityLevel();
     void toDecoBuffer(OutBuffer *buf, int flag);
+    void attributesToDecoBuffer(OutBuffer *buf);
     void toCBuffer(OutBuffer *buf, Identifier *ident, HdrGenState *hgs);
     void toCBufferWithAttributes(OutBuffer *buf, Identifier *ident, HdrGenState* hgs, TypeFunction *attrs, TemplateDeclaration *td);
     void toCBuffer2(OutBuffer *buf, HdrGenState *hgs, int mod);
@@ -1087,6 +1088,7 @@ public:
     Parameter *syntaxCopy();
     Type *isLazyArray();
     void toDecoBuffer(OutBuffer *buf);
+    void storageClassToDecoBuffer(OutBuffer *buf);
     int dyncast() { return DYNCAST_PARAMETER; } // kludge for template.isType()
     static Parameters *arraySyntaxCopy(Parameters *args);
     static char *argsTypesToChars(Parameters *args, int varargs);
@@ -1115,4 +1117,34 @@ int MODmethodConv(unsigned char modfrom, unsigned char modto);
 int MODmerge(unsigned char mod1, unsigned char mod2);
 void identifierToDocBuffer(Identifier* ident, OutBuffer *buf, HdrGenState *hgs);
 
+/* Builds mangled names front to back.  With -fmangle-backrefs, identifiers
+ * and types that were already written are replaced by a back reference:
+ * 'Q' followed by the distance back to the first one.
+ */
+struct AA;
+class Declaration;
+class FuncDeclaration;
+
+class Mangler
+{
+public:
+    OutBuffer *buf;
+    bool backrefs;
+    AA *idents;         // Identifier* => offset + 1
+    AA *types;          // merged deco => offset + 1
+
+    Mangler(OutBuffer *buf);
+    void mangleIdentifier(Identifier *id);
+    void mangleType(Type *t, int flag = 0);
+    void mangleDecl(Declaration *sthis, bool isv);
+
+private:
+    void writeBackref(size_t pos);
+    void mangleFuncType(TypeFunction *tf);
+    void mangleSymbol(Dsymbol *s, bool isv);
+    void mangleDsymbol(Dsymbol *s, bool isv);
+    void mangleExact(FuncDeclaration *fd, bool isv);
+    void manglePlain(const char *p);
+};
+
 #endif /* DMD_MTYPE_H */
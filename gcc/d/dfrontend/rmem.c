@@ -10,10 +10,17 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <assert.h>
 
 #include "rmem.h"
-
-/* This implementation of the storage allocator uses the standard C allocation package.
+#include "root.h"
+
+/* This implementation of the storage allocator carves memory out of large
+ * chunks obtained from the standard C allocation package.  The compiler hardly
+ * ever frees anything, so chunks are never given back; free() only reclaims
+ * the most recent allocation, and large blocks which get a malloc of their own.
+ * Each thread allocates from chunks of its own, so only the thread which made
+ * the most recent allocation can take it back.
  */
 
 Mem mem;
@@ -37,8 +44,430 @@ void mem_free(void *p)
 {
     mem.free(p);
 }
+
+void mem_printstats(FILE *fp)
+{
+    mem.printStats(fp);
+}
+
+void mem_endthread()
+{
+    mem.endThread();
+}
+
+void mem_pinregion()
+{
+    mem.pinRegion();
+}
 #endif
 
+#if 1
+
+/* Every block is preceded by a header holding its capacity, so realloc()
+ * knows how much to copy.  Blocks start on a 16 byte boundary (better, and
+ * sometimes needed, for doubles) and their capacity is rounded so the header
+ * of the next block exactly fills the gap.
+ */
+
+#define CHUNK_SIZE      (1024 * 1024 - 64)
+#define LARGE_SIZE      (CHUNK_SIZE / 8)        // bigger blocks get their own malloc
+#define HEADER_SIZE     8
+#define LARGE_BLOCK     1                       // flag in header of large blocks
+
+static THREAD_LOCAL size_t heapleft = 0;
+static THREAD_LOCAL char *heapp;
+static THREAD_LOCAL void *lastp;        // most recent allocation from a chunk
+
+// Statistics for -v
+static THREAD_LOCAL size_t nchunks;
+static THREAD_LOCAL size_t nlarge;
+static THREAD_LOCAL size_t totalsize;   // bytes ever requested
+static THREAD_LOCAL size_t inuse;       // bytes currently handed out
+static THREAD_LOCAL size_t peaksize;    // maximum of inuse
+
+// Statistics of the threads which have finished
+static size_t threadchunks;
+static size_t threadlarge;
+static size_t threadtotalsize;
+static size_t threadinuse;
+
+#define HEADER(p)       (*(size_t *)((char *)(p) - HEADER_SIZE))
+
+/* A region is a separate run of chunks and large blocks, which everything is
+ * allocated from between enterRegion() and leaveRegion().  Afterwards
+ * allocation carries on where it was before, and unless the region has been
+ * pinned, releaseRegion() gives all of it back at once.  Anything which may
+ * leave memory from outside the region pointing into it must pin it, as
+ * creating a Type or a Dsymbol does.  Regions are only used by the main
+ * thread.
+ */
+static int regiondepth;                 // nesting of enterRegion()
+static bool regionpinned;
+static bool regionlive;                 // regionchunks and regionlarge are valid
+static size_t regionid;                 // tags the large blocks of the region
+static char *regionchunks;              // linked through their first word
+static char *sparechunk;                // kept from the last region released
+static char **regionlarge;              // large blocks of the region
+static size_t regionlargedim;
+static size_t regionlargealloc;
+static size_t regionsize;               // bytes in use in the region
+
+// Allocation state from before the region
+static char *saveheapp;
+static size_t saveheapleft;
+static void *savelastp;
+static size_t saveinuse;
+
+// Large blocks keep the id of the region they belong to, or 0.
+#define REGIONTAG(p)    (*(size_t *)((char *)(p) - 16))
+
+static void *outOfMemory()
+{
+    printf("Error: out of memory\n");
+    exit(EXIT_FAILURE);
+    return NULL;
+}
+
+static void addInuse(size_t size)
+{
+    inuse += size;
+    if (inuse > peaksize)
+        peaksize = inuse;
+}
+
+// Capacity of a block of at least size bytes in a chunk.
+static size_t blockSize(size_t size)
+{
+    return ((size + HEADER_SIZE + 15) & ~(size_t)15) - HEADER_SIZE;
+}
+
+// Replace large block p of the region by q, or forget it if q is NULL.
+static void moveRegionLarge(char *p, char *q)
+{
+    for (size_t i = regionlargedim; i--; )
+    {
+        if (regionlarge[i] == p)
+        {
+            if (q)
+                regionlarge[i] = q;
+            else
+                regionlarge[i] = regionlarge[--regionlargedim];
+            return;
+        }
+    }
+}
+
+static void *allocLarge(size_t size)
+{
+    size = (size + 15) & ~(size_t)15;
+    char *p = (char *)::malloc(size + 16);
+    if (!p)
+        return outOfMemory();
+    p += 16;
+    HEADER(p) = size | LARGE_BLOCK;
+    REGIONTAG(p) = 0;
+    if (regiondepth)
+    {
+        if (regionlargedim == regionlargealloc)
+        {
+            regionlargealloc = regionlargealloc ? regionlargealloc * 2 : 16;
+            regionlarge = (char **)::realloc(regionlarge, regionlargealloc * sizeof(char *));
+            if (!regionlarge)
+                return outOfMemory();
+        }
+        regionlarge[regionlargedim++] = p;
+        REGIONTAG(p) = regionid;
+    }
+    nlarge++;
+    addInuse(size);
+    return p;
+}
+
+static char *newChunk()
+{
+    char *chunk;
+    if (regiondepth && sparechunk)
+    {
+        chunk = sparechunk;
+        sparechunk = NULL;
+    }
+    else
+    {
+        chunk = (char *)::malloc(CHUNK_SIZE);
+        if (!chunk)
+            return (char *)outOfMemory();
+        nchunks++;
+    }
+    if (regiondepth)
+    {   // The space before the first header holds the link
+        *(char **)chunk = regionchunks;
+        regionchunks = chunk;
+    }
+    return chunk;
+}
+
+static void *allocBlock(size_t size)
+{
+    if (size > LARGE_SIZE)
+        return allocLarge(size);
+
+    size_t m_size = blockSize(size);
+
+    // The layout of the code is selected so the most common case is straight through
+    if (m_size + HEADER_SIZE > heapleft)
+    {
+        char *chunk = newChunk();
+
+        // Keep heapp 8 bytes short of a 16 byte boundary, where the next header goes.
+        heapp = (char *)(((size_t)chunk + 15) & ~(size_t)15) + 16 - HEADER_SIZE;
+        heapleft = CHUNK_SIZE - (heapp - chunk);
+    }
+
+    char *p = heapp + HEADER_SIZE;
+    HEADER(p) = m_size;
+    heapp += m_size + HEADER_SIZE;
+    heapleft -= m_size + HEADER_SIZE;
+    lastp = p;
+    addInuse(m_size);
+    return p;
+}
+
+char *Mem::strdup(const char *s)
+{
+    if (s)
+    {
+        size_t len = strlen(s) + 1;
+        char *p = (char *)malloc(len);
+        memcpy(p, s, len);
+        return p;
+    }
+    return NULL;
+}
+
+void *Mem::malloc(size_t size)
+{
+    if (!size)
+        return NULL;
+    totalsize += size;
+    return allocBlock(size);
+}
+
+void *Mem::calloc(size_t size, size_t n)
+{
+    if (!size || !n)
+        return NULL;
+    void *p = malloc(size * n);
+    memset(p, 0, size * n);
+    return p;
+}
+
+void *Mem::realloc(void *p, size_t size)
+{
+    if (!size)
+    {
+        free(p);
+        return NULL;
+    }
+    if (!p)
+        return malloc(size);
+
+    size_t oldsize = HEADER(p);
+    if (oldsize & LARGE_BLOCK)
+    {
+        oldsize &= ~(size_t)LARGE_BLOCK;
+        size = (size + 15) & ~(size_t)15;
+        if (size > oldsize)
+            totalsize += size - oldsize;
+        char *q = (char *)::realloc((char *)p - 16, size + 16);
+        if (!q)
+            return outOfMemory();
+        q += 16;
+        HEADER(q) = size | LARGE_BLOCK;
+        if (regionlive && REGIONTAG(q) == regionid)
+            moveRegionLarge((char *)p, q);
+        inuse -= oldsize;
+        addInuse(size);
+        return q;
+    }
+
+    size_t m_size = blockSize(size);
+    if (m_size <= oldsize)
+    {
+        // Shrinking the most recent allocation gives the tail back.
+        if (p == lastp)
+        {
+            heapp -= oldsize - m_size;
+            heapleft += oldsize - m_size;
+            inuse -= oldsize - m_size;
+            HEADER(p) = m_size;
+        }
+        return p;
+    }
+
+    totalsize += size - oldsize;
+
+    // Extend the most recent allocation in place if the chunk has room.
+    if (p == lastp && size <= LARGE_SIZE && m_size - oldsize <= heapleft)
+    {
+        heapp += m_size - oldsize;
+        heapleft -= m_size - oldsize;
+        addInuse(m_size - oldsize);
+        HEADER(p) = m_size;
+        return p;
+    }
+
+    void *q = allocBlock(size);
+    memcpy(q, p, oldsize);
+    free(p);
+    return q;
+}
+
+void Mem::free(void *p)
+{
+    if (!p)
+        return;
+
+    size_t size = HEADER(p);
+    if (size & LARGE_BLOCK)
+    {
+        inuse -= size & ~(size_t)LARGE_BLOCK;
+        if (regionlive && REGIONTAG(p) == regionid)
+            moveRegionLarge((char *)p, NULL);
+        ::free((char *)p - 16);
+    }
+    else if (p == lastp)
+    {
+        heapp -= size + HEADER_SIZE;
+        heapleft += size + HEADER_SIZE;
+        inuse -= size;
+        lastp = NULL;
+    }
+}
+
+void *Mem::mallocdup(void *o, size_t size)
+{
+    if (!size)
+        return NULL;
+    void *p = malloc(size);
+    memcpy(p, o, size);
+    return p;
+}
+
+/* Allocate, but never release
+ */
+
+void * operator new(size_t m_size)
+{
+    totalsize += m_size;
+    return allocBlock(m_size ? m_size : 1);
+}
+
+void operator delete(void *p)
+{
+}
+
+/* Start allocating from a new region.
+ */
+void Mem::enterRegion()
+{
+    if (regiondepth++)
+        return;
+    saveheapp = heapp;
+    saveheapleft = heapleft;
+    savelastp = lastp;
+    saveinuse = inuse;
+    heapleft = 0;                       // so the next block starts a chunk
+    lastp = NULL;
+    regionid++;
+    regionpinned = false;
+    regionlive = true;
+    regionchunks = NULL;
+    regionlargedim = 0;
+}
+
+/* Go back to allocating from where we were before the region.
+ * Return true if the region can be released: the caller may then copy out
+ * what it needs before calling releaseRegion(), or just keep it.
+ */
+bool Mem::leaveRegion()
+{
+    assert(regiondepth);
+    if (--regiondepth)
+        return false;
+    regionsize = inuse > saveinuse ? inuse - saveinuse : 0;
+    if (regionpinned && heapleft > saveheapleft)
+        return false;                   // keep filling the region's last chunk
+    heapp = saveheapp;
+    heapleft = saveheapleft;
+    lastp = savelastp;
+    return !regionpinned;
+}
+
+/* Free everything allocated in the region left last.
+ */
+void Mem::releaseRegion()
+{
+    assert(!regiondepth && regionlive && !regionpinned);
+    while (regionchunks)
+    {
+        char *chunk = regionchunks;
+        regionchunks = *(char **)chunk;
+        if (!sparechunk)
+            sparechunk = chunk;
+        else
+        {
+            ::free(chunk);
+            nchunks--;
+        }
+    }
+    for (size_t i = 0; i < regionlargedim; i++)
+        ::free(regionlarge[i] - 16);
+    regionlargedim = 0;
+    regionlive = false;
+    inuse -= regionsize < inuse ? regionsize : inuse;
+}
+
+/* Something from outside the region now points into it, so it must be kept.
+ */
+void Mem::pinRegion()
+{
+    if (regiondepth)
+        regionpinned = true;
+}
+
+void Mem::printStats(FILE *fp)
+{
+    // What other threads allocated is never freed, so it adds to the peak
+    fprintf(fp, "memory    %u KB requested, %u KB peak, %u chunks of %u KB, %u large blocks\n",
+            (unsigned)((totalsize + threadtotalsize) / 1024),
+            (unsigned)((peaksize + threadinuse) / 1024),
+            (unsigned)(nchunks + threadchunks), (unsigned)(CHUNK_SIZE / 1024),
+            (unsigned)(nlarge + threadlarge));
+}
+
+/* The calling thread is about to finish, and its chunks carry on being
+ * used by the others.
+ */
+void Mem::endThread()
+{
+#if __GNUC__
+    __sync_fetch_and_add(&threadchunks, nchunks);
+    __sync_fetch_and_add(&threadlarge, nlarge);
+    __sync_fetch_and_add(&threadtotalsize, totalsize);
+    __sync_fetch_and_add(&threadinuse, inuse);
+#else
+    threadchunks += nchunks;
+    threadlarge += nlarge;
+    threadtotalsize += totalsize;
+    threadinuse += inuse;
+#endif
+}
+
+#else
+
+/* Forward everything to the standard C allocation package.
+ */
+
 char *Mem::strdup(const char *s)
 {
     char *p;
@@ -129,100 +558,67 @@ void *Mem::mallocdup(void *o, size_t size)
     return p;
 }
 
-void Mem::error()
+void * operator new(size_t m_size)
 {
+    void *p = ::malloc(m_size);
+    if (p)
+        return p;
     printf("Error: out of memory\n");
     exit(EXIT_FAILURE);
+    return p;
 }
 
-void Mem::fullcollect()
+void operator delete(void *p)
 {
+    ::free(p);
 }
 
-void Mem::mark(void *pointer)
+void Mem::enterRegion()
 {
-    (void) pointer;             // necessary for VC /W4
 }
 
-void Mem::setStackBottom(void *bottom)
+bool Mem::leaveRegion()
 {
+    return false;
 }
 
-void Mem::addroots(char* pStart, char* pEnd)
+void Mem::releaseRegion()
 {
 }
 
-
-/* =================================================== */
-
-#if 1
-
-/* Allocate, but never release
- */
-
-// Allocate a little less than 64kB because the C runtime adds some overhead that
-// causes the actual memory block to be larger than 64kB otherwise. E.g. the dmc
-// runtime rounds the size up to 128kB, but the remaining space in the chunk is less
-// than 64kB, so it cannot be used by another chunk.
-#define CHUNK_SIZE (4096 * 16 - 64)
-
-static size_t heapleft = 0;
-static void *heapp;
-
-void * operator new(size_t m_size)
+void Mem::pinRegion()
 {
-    // 16 byte alignment is better (and sometimes needed) for doubles
-    m_size = (m_size + 15) & ~15;
-
-    // The layout of the code is selected so the most common case is straight through
-    if (m_size <= heapleft)
-    {
-     L1:
-        heapleft -= m_size;
-        void *p = heapp;
-        heapp = (void *)((char *)heapp + m_size);
-        return p;
-    }
-
-    if (m_size > CHUNK_SIZE)
-    {
-        void *p = malloc(m_size);
-        if (p)
-            return p;
-        printf("Error: out of memory\n");
-        exit(EXIT_FAILURE);
-        return p;
-    }
+}
 
-    heapleft = CHUNK_SIZE;
-    heapp = malloc(CHUNK_SIZE);
-    if (!heapp)
-    {
-        printf("Error: out of memory\n");
-        exit(EXIT_FAILURE);
-    }
-    goto L1;
+void Mem::printStats(FILE *fp)
+{
 }
 
-void operator delete(void *p)
+void Mem::endThread()
 {
 }
 
-#else
+#endif
 
-void * operator new(size_t m_size)
+void Mem::error()
 {
-    void *p = malloc(m_size);
-    if (p)
-        return p;
     printf("Error: out of memory\n");
     exit(EXIT_FAILURE);
-    return p;
 }
 
-void operator delete(void *p)
+void Mem::fullcollect()
 {
-    free(p);
 }
 
-#endif
+void Mem::mark(void *pointer)
+{
+    (void) pointer;             // necessary for VC /W4
+}
+
+void Mem::setStackBottom(void *bottom)
+{
+}
+
+void Mem::addroots(char* pStart, char* pEnd)
+{
+}
@@ -11,6 +11,7 @@
 #define ROOT_MEM_H
 
 #include <stddef.h>     // for size_t
+#include <stdio.h>      // for FILE
 
 typedef void (*FINALIZERPROC)(void* pObj, void* pClientData);
 
@@ -50,6 +51,14 @@ struct Mem
     void setFinalizer(void* pObj, FINALIZERPROC pFn, void* pClientData);
     void setStackBottom(void *bottom);
     GC *getThreadGC();          // get apartment allocator for this thread
+    void printStats(FILE *fp);  // allocation statistics for -v
+    void endThread();           // add statistics of a finishing thread to the totals
+
+    // Regions of memory which can be given back all at once
+    void enterRegion();
+    bool leaveRegion();
+    void releaseRegion();
+    void pinRegion();
 };
 
 extern Mem mem;
@@ -20,4 +20,11 @@
 #include "outbuffer.h"
 #include "array.h"
 
+// Storage class of data which each thread has its own copy of
+#if __GNUC__
+#define THREAD_LOCAL    __thread
+#else
+#define THREAD_LOCAL    __declspec(thread)
+#endif
+
 #endif
@@ -13,6 +13,7 @@
 
 #include "mars.h"
 #include "statement.h"
+#include "expression.h"
 
 
 /**************************************
@@ -208,3 +209,119 @@ bool LabelStatement::apply(sapply_fp_t fp, void *param)
            (*fp)(this, param);
 }
 
+
+/**************************************
+ * Call Expression::apply(fp, param) on each of the expressions held
+ * directly by a Statement, but not on those of its nested Statements.
+ * Use together with Statement::apply() to visit every expression
+ * in a function body.
+ * Returns:
+ *      0       continue
+ *      1       done, or the expressions cannot be inspected
+ */
+
+#define econdApply(e, fp, param) (e ? e->apply(fp, param) : 0)
+
+int Statement::applyExps(apply_fp_t fp, void *param)
+{
+    return 0;
+}
+
+int ExpStatement::applyExps(apply_fp_t fp, void *param)
+{
+    return econdApply(exp, fp, param);
+}
+
+int WhileStatement::applyExps(apply_fp_t fp, void *param)
+{
+    return econdApply(condition, fp, param);
+}
+
+int DoStatement::applyExps(apply_fp_t fp, void *param)
+{
+    return econdApply(condition, fp, param);
+}
+
+int ForStatement::applyExps(apply_fp_t fp, void *param)
+{
+    return econdApply(condition, fp, param) ||
+           econdApply(increment, fp, param);
+}
+
+int ForeachStatement::applyExps(apply_fp_t fp, void *param)
+{
+    return econdApply(aggr, fp, param);
+}
+
+int ForeachRangeStatement::applyExps(apply_fp_t fp, void *param)
+{
+    return econdApply(lwr, fp, param) ||
+           econdApply(upr, fp, param);
+}
+
+int IfStatement::applyExps(apply_fp_t fp, void *param)
+{
+    return econdApply(condition, fp, param);
+}
+
+int PragmaStatement::applyExps(apply_fp_t fp, void *param)
+{
+    return econdApply(args, fp, param);
+}
+
+int SwitchStatement::applyExps(apply_fp_t fp, void *param)
+{
+    return econdApply(condition, fp, param);
+}
+
+int CaseStatement::applyExps(apply_fp_t fp, void *param)
+{
+    return econdApply(exp, fp, param);
+}
+
+int CaseRangeStatement::applyExps(apply_fp_t fp, void *param)
+{
+    return econdApply(first, fp, param) ||
+           econdApply(last, fp, param);
+}
+
+int GotoCaseStatement::applyExps(apply_fp_t fp, void *param)
+{
+    return econdApply(exp, fp, param);
+}
+
+int ReturnStatement::applyExps(apply_fp_t fp, void *param)
+{
+    return econdApply(exp, fp, param);
+}
+
+int SynchronizedStatement::applyExps(apply_fp_t fp, void *param)
+{
+    return econdApply(exp, fp, param);
+}
+
+int WithStatement::applyExps(apply_fp_t fp, void *param)
+{
+    return econdApply(exp, fp, param);
+}
+
+int ThrowStatement::applyExps(apply_fp_t fp, void *param)
+{
+    return econdApply(exp, fp, param);
+}
+
+int AsmStatement::applyExps(apply_fp_t fp, void *param)
+{
+    // Operands are still tokens, so nothing can be said about them.
+    return 1;
+}
+
+#ifdef IN_GCC
+int ExtAsmStatement::applyExps(apply_fp_t fp, void *param)
+{
+    return econdApply(insn, fp, param) ||
+           econdApply(args, fp, param) ||
+           econdApply(constraints, fp, param) ||
+           econdApply(clobbers, fp, param);
+}
+#endif
@@ -32,6 +32,8 @@ Scope *Scope::freelist = NULL;
 
 void *Scope::operator new(size_t size)
 {
+    // Semantic analysis is starting, which keeps what it allocates
+    mem.pinRegion();
     if (freelist)
     {
         Scope *s = freelist;
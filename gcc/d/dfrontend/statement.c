@@ -1747,6 +1747,18 @@ Lagain:
               *   for (T[] tmp = a[], size_t key = tmp.length; key--; )
               *   { T value = tmp[k]; body }
               */
+            /* An array literal aggregate is only reachable through tmp,
+             * so unless the value is a ref to its elements it can be
+             * allocated on the stack.
+             */
+            if (aggr->op == TOKarrayliteral &&
+                !((*arguments)[dim - 1]->storageClass & STCref))
+            {
+                ArrayLiteralExp *ale = (ArrayLiteralExp *)aggr->copy();
+                ale->onstack = 1;
+                aggr = ale;
+            }
+
             Identifier *id = Lexer::uniqueId("__aggr");
             ExpInitializer *ie = new ExpInitializer(loc, new SliceExp(loc, aggr, NULL, NULL));
             VarDeclaration *tmp = new VarDeclaration(loc, tab->nextOf()->arrayOf(), id, ie);
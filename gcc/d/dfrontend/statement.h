@@ -56,6 +56,7 @@ struct CompiledCtfeFunction;
 enum TOK;
 
 typedef bool (*sapply_fp_t)(Statement *, void *);
+typedef int (*apply_fp_t)(Expression *, void *);
 
 // Back end
 struct IRState;
@@ -117,6 +118,7 @@ public:
     virtual Statements *flatten(Scope *sc);
     virtual Expression *interpret(InterState *istate);
     virtual bool apply(sapply_fp_t fp, void *param);
+    virtual int applyExps(apply_fp_t fp, void *param);
     virtual void ctfeCompile(CompiledCtfeFunction *ccf);
     virtual Statement *last();
 
@@ -176,6 +178,7 @@ public:
     Statement *semantic(Scope *sc);
     Expression *interpret(InterState *istate);
     void ctfeCompile(CompiledCtfeFunction *ccf);
+    int applyExps(apply_fp_t fp, void *param);
     int blockExit(bool mustNotThrow);
     bool hasCodeImpl();
     Statement *scopeCode(Scope *sc, Statement **sentry, Statement **sexit, Statement **sfinally);
@@ -322,6 +325,7 @@ public:
     Expression *interpret(InterState *istate);
     bool apply(sapply_fp_t fp, void *param);
     void ctfeCompile(CompiledCtfeFunction *ccf);
+    int applyExps(apply_fp_t fp, void *param);
     void toCBuffer(OutBuffer *buf, HdrGenState *hgs);
 
     Statement *inlineScan(InlineScanState *iss);
@@ -344,6 +348,7 @@ public:
     Expression *interpret(InterState *istate);
     bool apply(sapply_fp_t fp, void *param);
     void ctfeCompile(CompiledCtfeFunction *ccf);
+    int applyExps(apply_fp_t fp, void *param);
     void toCBuffer(OutBuffer *buf, HdrGenState *hgs);
 
     Statement *inlineScan(InlineScanState *iss);
@@ -375,6 +380,7 @@ public:
     Expression *interpret(InterState *istate);
     bool apply(sapply_fp_t fp, void *param);
     void ctfeCompile(CompiledCtfeFunction *ccf);
+    int applyExps(apply_fp_t fp, void *param);
     void toCBuffer(OutBuffer *buf, HdrGenState *hgs);
 
     int inlineCost(InlineCostState *ics);
@@ -412,6 +418,7 @@ public:
     Expression *interpret(InterState *istate);
     bool apply(sapply_fp_t fp, void *param);
     void ctfeCompile(CompiledCtfeFunction *ccf);
+    int applyExps(apply_fp_t fp, void *param);
     void toCBuffer(OutBuffer *buf, HdrGenState *hgs);
 
     Statement *inlineScan(InlineScanState *iss);
@@ -441,6 +448,7 @@ public:
     Expression *interpret(InterState *istate);
     bool apply(sapply_fp_t fp, void *param);
     void ctfeCompile(CompiledCtfeFunction *ccf);
+    int applyExps(apply_fp_t fp, void *param);
     void toCBuffer(OutBuffer *buf, HdrGenState *hgs);
 
     Statement *inlineScan(InlineScanState *iss);
@@ -465,6 +473,7 @@ public:
     Expression *interpret(InterState *istate);
     bool apply(sapply_fp_t fp, void *param);
     void ctfeCompile(CompiledCtfeFunction *ccf);
+    int applyExps(apply_fp_t fp, void *param);
     void toCBuffer(OutBuffer *buf, HdrGenState *hgs);
     int blockExit(bool mustNotThrow);
     IfStatement *isIfStatement() { return this; }
@@ -506,6 +515,7 @@ public:
     Statement *semantic(Scope *sc);
     int blockExit(bool mustNotThrow);
     bool apply(sapply_fp_t fp, void *param);
+    int applyExps(apply_fp_t fp, void *param);
 
     void toCBuffer(OutBuffer *buf, HdrGenState *hgs);
 
@@ -547,6 +557,7 @@ public:
     Expression *interpret(InterState *istate);
     bool apply(sapply_fp_t fp, void *param);
     void ctfeCompile(CompiledCtfeFunction *ccf);
+    int applyExps(apply_fp_t fp, void *param);
     void toCBuffer(OutBuffer *buf, HdrGenState *hgs);
 
     Statement *inlineScan(InlineScanState *iss);
@@ -572,6 +583,7 @@ public:
     Expression *interpret(InterState *istate);
     bool apply(sapply_fp_t fp, void *param);
     void ctfeCompile(CompiledCtfeFunction *ccf);
+    int applyExps(apply_fp_t fp, void *param);
     void toCBuffer(OutBuffer *buf, HdrGenState *hgs);
     CaseStatement *isCaseStatement() { return this; }
 
@@ -593,6 +605,7 @@ public:
     Statement *syntaxCopy();
     Statement *semantic(Scope *sc);
     bool apply(sapply_fp_t fp, void *param);
+    int applyExps(apply_fp_t fp, void *param);
     void toCBuffer(OutBuffer *buf, HdrGenState *hgs);
 };
 
@@ -649,6 +662,7 @@ public:
     Statement *semantic(Scope *sc);
     Expression *interpret(InterState *istate);
     void ctfeCompile(CompiledCtfeFunction *ccf);
+    int applyExps(apply_fp_t fp, void *param);
     int blockExit(bool mustNotThrow);
     void toCBuffer(OutBuffer *buf, HdrGenState *hgs);
 
@@ -679,6 +693,7 @@ public:
     int blockExit(bool mustNotThrow);
     Expression *interpret(InterState *istate);
     void ctfeCompile(CompiledCtfeFunction *ccf);
+    int applyExps(apply_fp_t fp, void *param);
 
     int inlineCost(InlineCostState *ics);
     Expression *doInline(InlineDoState *ids);
@@ -736,6 +751,7 @@ public:
     bool usesEHimpl();
     int blockExit(bool mustNotThrow);
     bool apply(sapply_fp_t fp, void *param);
+    int applyExps(apply_fp_t fp, void *param);
     void toCBuffer(OutBuffer *buf, HdrGenState *hgs);
 
     Statement *inlineScan(InlineScanState *iss);
@@ -761,6 +777,7 @@ public:
     Expression *interpret(InterState *istate);
     bool apply(sapply_fp_t fp, void *param);
     void ctfeCompile(CompiledCtfeFunction *ccf);
+    int applyExps(apply_fp_t fp, void *param);
 
     Statement *inlineScan(InlineScanState *iss);
 
@@ -864,6 +881,7 @@ public:
     int blockExit(bool mustNotThrow);
     Expression *interpret(InterState *istate);
     void ctfeCompile(CompiledCtfeFunction *ccf);
+    int applyExps(apply_fp_t fp, void *param);
 
     Statement *inlineScan(InlineScanState *iss);
 
@@ -955,6 +973,7 @@ public:
     bool comeFromImpl();
     Expression *interpret(InterState *istate);
     void ctfeCompile(CompiledCtfeFunction *ccf);
+    int applyExps(apply_fp_t fp, void *param);
 
     void toCBuffer(OutBuffer *buf, HdrGenState *hgs);
 
@@ -1009,6 +1028,7 @@ public:
     bool comeFromImpl();
     Expression *interpret(InterState *istate);
     void ctfeCompile(CompiledCtfeFunction *ccf);
+    int applyExps(apply_fp_t fp, void *param);
 
     void toCBuffer(OutBuffer *buf, HdrGenState *hgs);
 
@@ -18,41 +18,45 @@
 #include "stringtable.h"
 
 // TODO: Merge with root.String
+// MurmurHash2 by Austin Appleby, which distributes identifiers and type
+// decos far better than a plain multiplicative hash.
 hash_t calcHash(const char *str, size_t len)
 {
-    hash_t hash = 0;
+    const uint32_t m = 0x5bd1e995;
+    const int r = 24;
 
-    while (1)
+    uint32_t h = (uint32_t) len;
+    const uint8_t *data = (const uint8_t *)str;
+
+    while (len >= 4)
     {
-        switch (len)
-        {
-            case 0:
-                return hash;
-
-            case 1:
-                hash *= 37;
-                hash += *(const uint8_t *)str;
-                return hash;
-
-            case 2:
-                hash *= 37;
-                hash += *(const uint16_t *)str;
-                return hash;
-
-            case 3:
-                hash *= 37;
-                hash += (*(const uint16_t *)str << 8) +
-                        ((const uint8_t *)str)[2];
-                return hash;
-
-            default:
-                hash *= 37;
-                hash += *(const uint32_t *)str;
-                str += 4;
-                len -= 4;
-                break;
-        }
+        uint32_t k;
+        memcpy(&k, data, sizeof(k));
+
+        k *= m;
+        k ^= k >> r;
+        k *= m;
+
+        h *= m;
+        h ^= k;
+
+        data += 4;
+        len -= 4;
+    }
+
+    switch (len)
+    {
+        case 3: h ^= data[2] << 16;
+        case 2: h ^= data[1] << 8;
+        case 1: h ^= data[0];
+                h *= m;
     }
+
+    h ^= h >> 13;
+    h *= m;
+    h ^= h >> 15;
+
+    return h;
 }
 
 void StringValue::ctor(const char *p, size_t length)
@@ -62,115 +66,212 @@ void StringValue::ctor(const char *p, size_t length)
     memcpy(this->lstring, p, length * sizeof(char));
 }
 
+struct StringEntry
+{
+    StringValue *value;         // NULL if the slot is empty
+    hash_t hash;
+};
+
+// Size of each pool that StringValues are allocated from.  Strings which
+// do not fit get a pool of their own.
+#define POOL_SIZE (4096 * 16 - 64)
+
 void StringTable::_init(size_t size)
 {
-    table = (void **)mem.calloc(size, sizeof(void *));
-    tabledim = size;
+    // Round up to a power of 2, leaving room for the load factor.
+    size = size + size / 3;
+    tabledim = 32;
+    while (tabledim < size)
+        tabledim <<= 1;
+
+    table = (StringEntry *)mem.calloc(tabledim, sizeof(StringEntry));
     count = 0;
+
+    pools = NULL;
+    npools = 0;
+    nfill = 0;
+
+    nsearches = 0;
+    nprobes = 0;
+    ngrows = 0;
 }
 
 StringTable::~StringTable()
 {
-    // Zero out dangling pointers to help garbage collector.
-    // Should zero out StringEntry's too.
-    for (size_t i = 0; i < count; i++)
-        table[i] = NULL;
+    for (size_t i = 0; i < npools; i++)
+        mem.free(pools[i]);
 
+    mem.free(pools);
     mem.free(table);
+    pools = NULL;
     table = NULL;
 }
 
-struct StringEntry
+/**********************************
+ * Bump allocate a new StringValue for s[0 .. len].
+ */
+
+StringValue *StringTable::allocValue(const char *s, size_t len)
 {
-    StringEntry *left;
-    StringEntry *right;
-    hash_t hash;
+    // Entries live as long as the table, so can't go in a CTFE region.
+    mem.pinRegion();
 
-    StringValue value;
+    // Keep each StringValue pointer aligned.
+    size_t nbytes = sizeof(StringValue) + len + 1;
+    nbytes = (nbytes + sizeof(void *) - 1) & ~(sizeof(void *) - 1);
 
-    static StringEntry *alloc(const char *s, size_t len);
-};
+    uint8_t *p;
+    if (nbytes > POOL_SIZE)
+    {
+        // Too big, give it its own pool but keep on filling the current one.
+        p = (uint8_t *)mem.malloc(nbytes);
+        pools = (uint8_t **)mem.realloc(pools, (npools + 1) * sizeof(uint8_t *));
+        if (npools)
+        {
+            pools[npools] = pools[npools - 1];
+            pools[npools - 1] = p;
+        }
+        else
+        {
+            pools[0] = p;
+            nfill = POOL_SIZE;
+        }
+        npools++;
+    }
+    else
+    {
+        if (!npools || nfill + nbytes > POOL_SIZE)
+        {
+            pools = (uint8_t **)mem.realloc(pools, (npools + 1) * sizeof(uint8_t *));
+            pools[npools++] = (uint8_t *)mem.malloc(POOL_SIZE);
+            nfill = 0;
+        }
+        p = pools[npools - 1] + nfill;
+        nfill += nbytes;
+    }
 
-StringEntry *StringEntry::alloc(const char *s, size_t len)
-{
-    StringEntry *se;
+    StringValue *sv = (StringValue *)p;
+    sv->ptrvalue = NULL;
+    sv->ctor(s, len);
+    return sv;
+}
 
-    se = (StringEntry *) mem.calloc(1,sizeof(StringEntry) + len + 1);
-    se->value.ctor(s, len);
-    se->hash = calcHash(s,len);
-    return se;
+/**********************************
+ * Return the index of the slot holding s[0 .. len], or of the empty
+ * slot where it would be inserted.  Uses quadratic (triangular) probing,
+ * which visits every slot of a power of 2 sized table.
+ */
+
+size_t StringTable::findSlot(hash_t hash, const char *s, size_t len)
+{
+    nsearches++;
+    for (size_t i = hash & (tabledim - 1), j = 1; ; ++j)
+    {
+        nprobes++;
+        StringValue *sv = table[i].value;
+        if (!sv ||
+            (table[i].hash == hash &&
+             sv->len() == len &&
+             ::memcmp(s, sv->toDchars(), len) == 0))
+            return i;
+        i = (i + j) & (tabledim - 1);
+    }
 }
 
-void **StringTable::search(const char *s, size_t len)
+/**********************************
+ * Double the size of the table and rehash all entries.
+ */
+
+void StringTable::grow()
 {
-    hash_t hash;
-    unsigned u;
-    int cmp;
-    StringEntry **se;
-
-    //printf("StringTable::search(%p,%d)\n",s,len);
-    hash = calcHash(s,len);
-    u = hash % tabledim;
-    se = (StringEntry **)&table[u];
-    //printf("\thash = %d, u = %d\n",hash,u);
-    while (*se)
+    StringEntry *otable = table;
+    size_t odim = tabledim;
+
+    tabledim *= 2;
+    table = (StringEntry *)mem.calloc(tabledim, sizeof(StringEntry));
+    ngrows++;
+
+    for (size_t i = 0; i < odim; i++)
     {
-        cmp = (*se)->hash - hash;
-        if (cmp == 0)
-        {
-            cmp = (*se)->value.len() - len;
-            if (cmp == 0)
-            {
-                cmp = ::memcmp(s,(*se)->value.toDchars(),len);
-                if (cmp == 0)
-                    break;
-            }
-        }
-        if (cmp < 0)
-            se = &(*se)->left;
-        else
-            se = &(*se)->right;
+        StringEntry *se = &otable[i];
+        if (!se->value)
+            continue;
+
+        size_t j = se->hash & (tabledim - 1);
+        for (size_t k = 1; table[j].value; ++k)
+            j = (j + k) & (tabledim - 1);
+        table[j] = *se;
     }
-    //printf("\treturn %p, %p\n",se, (*se));
-    return (void **)se;
+
+    mem.free(otable);
 }
 
 StringValue *StringTable::lookup(const char *s, size_t len)
-{   StringEntry *se;
-
-    se = *(StringEntry **)search(s,len);
-    if (se)
-        return &se->value;
-    else
-        return NULL;
+{
+    hash_t hash = calcHash(s, len);
+    size_t i = findSlot(hash, s, len);
+    return table[i].value;
 }
 
 StringValue *StringTable::update(const char *s, size_t len)
-{   StringEntry **pse;
-    StringEntry *se;
-
-    pse = (StringEntry **)search(s,len);
-    se = *pse;
-    if (!se)                    // not in table: so create new entry
+{
+    hash_t hash = calcHash(s, len);
+    size_t i = findSlot(hash, s, len);
+    if (!table[i].value)        // not in table: so create new entry
     {
-        se = StringEntry::alloc(s, len);
-        *pse = se;
+        if (++count * 4 > tabledim * 3)
+        {
+            grow();
+            i = findSlot(hash, s, len);
+        }
+        table[i].value = allocValue(s, len);
+        table[i].hash = hash;
     }
-    return &se->value;
+    return table[i].value;
 }
 
 StringValue *StringTable::insert(const char *s, size_t len)
-{   StringEntry **pse;
-    StringEntry *se;
-
-    pse = (StringEntry **)search(s,len);
-    se = *pse;
-    if (se)
+{
+    hash_t hash = calcHash(s, len);
+    size_t i = findSlot(hash, s, len);
+    if (table[i].value)
         return NULL;            // error: already in table
-    else
+
+    if (++count * 4 > tabledim * 3)
     {
-        se = StringEntry::alloc(s, len);
-        *pse = se;
+        grow();
+        i = findSlot(hash, s, len);
     }
-    return &se->value;
+    table[i].value = allocValue(s, len);
+    table[i].hash = hash;
+    return table[i].value;
+}
+
+/**********************************
+ * Print load factor and probe length statistics, for -fd-verbose.
+ */
+
+void StringTable::printStats(FILE *fp, const char *name)
+{
+    // Longest probe sequence of any entry currently in the table.
+    size_t maxprobe = 0;
+    for (size_t i = 0; i < tabledim; i++)
+    {
+        if (!table[i].value)
+            continue;
+
+        size_t n = 1;
+        for (size_t j = table[i].hash & (tabledim - 1); j != i; ++n)
+            j = (j + n) & (tabledim - 1);
+        if (n > maxprobe)
+            maxprobe = n;
+    }
+
+    fprintf(fp, "stringtable %s: %u entries, %u slots, load %.2f, %u grows\n",
+            name, (unsigned)count, (unsigned)tabledim,
+            (double)count / tabledim, (unsigned)ngrows);
+    fprintf(fp, "stringtable %s: %u searches, %.2f probes/search, %u max probe, %u pools\n",
+            name, (unsigned)nsearches,
+            nsearches ? (double)nprobes / nsearches : 0.0,
+            (unsigned)maxprobe, (unsigned)npools);
 }
@@ -15,6 +15,9 @@
 #pragma once
 #endif
 
+#include <stdio.h>
+#include <stdint.h>
+
 #include "root.h"
 
 struct StringEntry;
@@ -39,29 +42,48 @@ public:
     const char *toDchars() const { return lstring; }
 
 private:
-    friend struct StringEntry;
+    friend struct StringTable;
     StringValue();  // not constructible
     // This is more like a placement new c'tor
     void ctor(const char *p, size_t length);
 };
 
+// Open addressing hash table of StringValues.  The table is kept at a load
+// factor below 3/4 and doubles in size when it fills up.  The StringValues
+// themselves are bump allocated from a list of pools and never move, so the
+// pointers returned by lookup/insert/update stay valid for the table's life.
 struct StringTable
 {
 private:
-    void **table;
+    StringEntry *table;
+    size_t tabledim;            // always a power of 2
     size_t count;
-    size_t tabledim;
+
+    uint8_t **pools;            // storage for the StringValues
+    size_t npools;
+    size_t nfill;               // bytes used in the current pool
+
+    // Statistics, reported by printStats()
+    size_t nsearches;
+    size_t nprobes;
+    size_t ngrows;
 
 public:
-    void _init(size_t size = 37);
+    void _init(size_t size = 0);
     ~StringTable();
 
     StringValue *lookup(const char *s, size_t len);
     StringValue *insert(const char *s, size_t len);
     StringValue *update(const char *s, size_t len);
 
+    void printStats(FILE *fp, const char *name);
+
 private:
-    void **search(const char *s, size_t len);
+    size_t findSlot(hash_t hash, const char *s, size_t len);
+    StringValue *allocValue(const char *s, size_t len);
+    void grow();
 };
 
+hash_t calcHash(const char *str, size_t len);
+
 #endif
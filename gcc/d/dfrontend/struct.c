@@ -571,18 +571,32 @@ StructDeclaration::StructDeclaration(Loc loc, Identifier *id)
     type = new TypeStruct(this);
 
 #if MODULEINFO_IS_STRUCT
+    if (id == Id::ModuleInfo)
+    {   // Unless parsing ahead on a worker thread: then the module does it,
+        // once it is really parsed
+        if (Module::parsingAhead)
+        {   if (!Module::parsingAhead->aheadModuleInfo)
+                Module::parsingAhead->aheadModuleInfo = this;
+        }
+        else
+            setModuleInfo();
+    }
+#endif
+}
+
+#if MODULEINFO_IS_STRUCT
+void StructDeclaration::setModuleInfo()
+{
   #ifdef DMDV2
-    if (id == Id::ModuleInfo && !Module::moduleinfo)
+    if (!Module::moduleinfo)
         Module::moduleinfo = this;
   #else
-    if (id == Id::ModuleInfo)
-    {   if (Module::moduleinfo)
-            Module::moduleinfo->error("only object.d can define this reserved struct name");
-        Module::moduleinfo = this;
-    }
+    if (Module::moduleinfo)
+        Module::moduleinfo->error("only object.d can define this reserved struct name");
+    Module::moduleinfo = this;
   #endif
-#endif
 }
+#endif
 
 Dsymbol *StructDeclaration::syntaxCopy(Dsymbol *s)
 {
@@ -5150,6 +5150,7 @@ TemplateInstance::TemplateInstance(Loc loc, Identifier *ident)
     this->speculative = false;
     this->hash = 0;
     this->fargs = NULL;
+    this->tocharsString = NULL;
 }
 
 /*****************
@@ -5180,6 +5181,7 @@ TemplateInstance::TemplateInstance(Loc loc, TemplateDeclaration *td, Objects *ti
     this->speculative = false;
     this->hash = 0;
     this->fargs = NULL;
+    this->tocharsString = NULL;
 
     assert(tempdecl->scope);
 }
@@ -6653,8 +6655,9 @@ Identifier *TemplateInstance::genIdent(Objects *args)
 
     //printf("TemplateInstance::genIdent('%s')\n", tempdecl->ident->toChars());
     OutBuffer buf;
-    char *id = tempdecl->ident->toChars();
-    buf.printf("__T%llu%s", (ulonglong)strlen(id), id);
+    Mangler v(&buf);
+    buf.writestring("__T");
+    v.mangleIdentifier(tempdecl->ident);
     for (size_t i = 0; i < args->dim; i++)
     {
         RootObject *o = (*args)[i];
@@ -6667,7 +6670,7 @@ Identifier *TemplateInstance::genIdent(Objects *args)
         {
             buf.writeByte('T');
             if (ta->deco)
-                buf.writestring(ta->deco);
+                v.mangleType(ta);
             else
             {
 #ifdef DEBUG
@@ -6715,7 +6718,7 @@ Identifier *TemplateInstance::genIdent(Objects *args)
 #if 1
             /* Use deco that matches what it would be for a function parameter
              */
-            buf.writestring(ea->type->deco);
+            v.mangleType(ea->type);
 #else
             // Use type of parameter, not type of argument
             TemplateParameter *tp = (*tempdecl->parameters)[i];
@@ -6769,7 +6772,7 @@ Identifier *TemplateInstance::genIdent(Objects *args)
             assert(0);
     }
     buf.writeByte('Z');
-    id = buf.toChars();
+    char *id = buf.toChars();
     //buf.data = NULL;                          // we can free the string after call to idPool()
     //printf("\tgenIdent = %s\n", id);
     return Lexer::idPool(id);
@@ -7090,11 +7093,23 @@ bool TemplateInstance::oneMember(Dsymbol **ps, Identifier *ident)
 
 char *TemplateInstance::toChars()
 {
+    /* The arguments, and so the string, are final once
+     * semantic() has run.
+     */
+    bool done = semanticRun >= PASSsemanticdone;
+    if (done && tocharsString)
+        return (char *)tocharsString;
+
     OutBuffer buf;
     HdrGenState hgs;
     char *s;
 
     toCBuffer(&buf, &hgs);
+    if (done)
+    {
+        tocharsString = internString((char *)buf.data, buf.offset);
+        return (char *)tocharsString;
+    }
     s = buf.toChars();
     buf.data = NULL;
     return s;
@@ -0,0 +1,52 @@
+#!/bin/sh
+
+# GDC -- D front-end for GCC
+# Copyright (C) 2013 Free Software Foundation, Inc.
+#
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 2 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with GCC; see the file COPYING3.  If not see
+# <http://www.gnu.org/licenses/>.
+
+# Check whether the host compiler can build and link the worker threads
+# of -fparse-threads, and with which library.  The library is written to
+# the file named by the first argument, and the header for d-lang.cc and
+# d-glue.cc to the standard output.  The rest of the arguments are the
+# command to compile and link with.
+
+libsfile=$1
+shift
+
+conftest=d/conftest-pthread$$
+cat > $conftest.cc <<EOT
+#include <pthread.h>
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static void *run (void *p) { pthread_mutex_lock (&lock); return p; }
+int main () { pthread_t t; return pthread_create (&t, 0, run, 0) || pthread_join (t, 0); }
+EOT
+
+found=no
+for libs in "" "-lpthread" "-pthread"; do
+  if "$@" -o $conftest $conftest.cc $libs > /dev/null 2>&1; then
+    found=yes
+    break
+  fi
+done
+rm -f $conftest $conftest.cc $conftest.o
+
+if test $found = yes; then
+  echo "$libs" > $libsfile
+  echo "#define HAVE_D_PTHREAD   1"
+else
+  echo "" > $libsfile
+  echo "/* No POSIX threads, -fparse-threads is ignored.  */"
+fi